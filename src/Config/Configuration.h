@@ -181,18 +181,30 @@ constexpr size_t ShortGCodeLength = 64;
 // When using RTOS, it is best if it is possible to fit an HTTP response header in a single buffer. Our headers are currently about 230 bytes long.
 // A note on reserved buffers: the worst case is when a GCode with a long response is processed. After string the response, there must be enough buffer space
 // for the HTTP responder to return a status response. Otherwise DWC never gets to know that it needs to make a rr_reply call and the system deadlocks.
+// Long responses are extended using large output buffers when there are any free, so that big object model reports and file lists need fewer buffers.
 #if SAME70 || SAME5x
 constexpr size_t OUTPUT_BUFFER_SIZE = 256;				// How many bytes does each OutputBuffer hold?
 constexpr size_t OUTPUT_BUFFER_COUNT = 40;				// How many OutputBuffer instances do we have?
 constexpr size_t RESERVED_OUTPUT_BUFFERS = 4;			// Number of reserved output buffers after long responses, enough to hold a status response
+# if SAME70
+constexpr size_t OUTPUT_LARGE_BUFFER_SIZE = 2048;		// How many bytes does each large OutputBuffer hold?
+constexpr size_t OUTPUT_LARGE_BUFFER_COUNT = 6;			// How many large OutputBuffer instances do we have?
+# else
+constexpr size_t OUTPUT_LARGE_BUFFER_SIZE = 1024;		// How many bytes does each large OutputBuffer hold?
+constexpr size_t OUTPUT_LARGE_BUFFER_COUNT = 4;			// How many large OutputBuffer instances do we have?
+# endif
 #elif SAM4E || SAM4S
 constexpr size_t OUTPUT_BUFFER_SIZE = 256;				// How many bytes does each OutputBuffer hold?
 constexpr size_t OUTPUT_BUFFER_COUNT = 26;				// How many OutputBuffer instances do we have?
 constexpr size_t RESERVED_OUTPUT_BUFFERS = 4;			// Number of reserved output buffers after long responses, enough to hold a status response
+constexpr size_t OUTPUT_LARGE_BUFFER_SIZE = 0;			// We don't have enough RAM for large output buffers
+constexpr size_t OUTPUT_LARGE_BUFFER_COUNT = 0;
 #elif __LPC17xx__
 constexpr uint16_t OUTPUT_BUFFER_SIZE = 256;            // How many bytes does each OutputBuffer hold?
 constexpr size_t OUTPUT_BUFFER_COUNT = 16;              // How many OutputBuffer instances do we have?
 constexpr size_t RESERVED_OUTPUT_BUFFERS = 2;           // Number of reserved output buffers after long responses. Must be enough for an HTTP header
+constexpr size_t OUTPUT_LARGE_BUFFER_SIZE = 0;			// We don't have enough RAM for large output buffers
+constexpr size_t OUTPUT_LARGE_BUFFER_COUNT = 0;
 #else
 # error
 #endif
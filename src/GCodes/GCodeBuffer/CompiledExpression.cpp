@@ -0,0 +1,672 @@
+/*
+ * CompiledExpression.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "CompiledExpression.h"
+
+#if SUPPORT_COMPILED_EXPRESSIONS
+
+#include "ExpressionParser.h"
+#include "GCodeBuffer.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Movement/StepTimer.h>
+#include <General/NumericConverter.h>
+
+// Instructions. Text offsets are from the start of the expression and are used to report errors in the right column.
+enum class Opcode : uint8_t
+{
+	end = 0,				// end of code, the result is on the stack
+	pushInt,				// followed by a 4-byte integer
+	pushFloat,				// followed by the number of decimal digits to display and a 4-byte float
+	pushOperand,			// followed by the text offset and length of an operand to be evaluated by ExpressionParser
+	unaryOp,				// followed by the operator character and the text offset
+	binaryOp,				// followed by the operator character, the invert flag and the text offset
+	toBool,					// followed by the text offset
+	andJump,				// followed by the text offset and the jump target. Convert the top of stack to Boolean, then jump if false, else pop it.
+	orJump,					// followed by the text offset and the jump target. Convert the top of stack to Boolean, then jump if true, else pop it.
+	condJump,				// followed by the text offset and the jump target. Convert the top of stack to Boolean and pop it, then jump if false.
+	jump					// followed by the jump target
+};
+
+// Class to compile an expression. This follows the structure of ExpressionParser::ParseInternal so that the compiled code evaluates the same operands
+// in the same order, and it gives up on anything that ExpressionParser would report as an error so that ExpressionParser gets to report it.
+class ExpressionCompiler
+{
+public:
+	ExpressionCompiler(const char *_ecv_array t, size_t length, uint8_t *_ecv_array c) noexcept
+		: text(t), textLength(length), code(c), pos(0), codeLength(0), depth(0) { }
+
+	bool Compile(bool condition) noexcept;
+	size_t GetCodeLength() const noexcept { return codeLength; }
+
+private:
+	bool CompileInternal(uint8_t priority) noexcept;
+	bool CompileOperand(size_t start) noexcept;
+	bool CompileNumber() noexcept;
+
+	bool ScanQuotedString() noexcept;
+	bool ScanIdentifier() noexcept;
+	bool ScanBracketed(char closingBracket) noexcept;
+
+	char CurrentCharacter() const noexcept { return (pos < textLength) ? text[pos] : 0; }
+	void SkipWhiteSpace() noexcept;
+
+	bool Emit(uint8_t b) noexcept;
+	bool Emit(Opcode op) noexcept { return Emit((uint8_t)op); }
+	bool EmitBytes(const void *p, size_t n) noexcept;
+	bool Push() noexcept;
+	void Pop() noexcept { --depth; }
+
+	const char *_ecv_array text;
+	size_t textLength;
+	uint8_t *_ecv_array code;
+	size_t pos;
+	size_t codeLength;
+	size_t depth;
+};
+
+bool ExpressionCompiler::Compile(bool condition) noexcept
+{
+	if (!CompileInternal(0))
+	{
+		return false;
+	}
+
+	// We only compile expressions that run to the end of the text, so that we don't need to report extra characters
+	SkipWhiteSpace();
+	if (pos != textLength)
+	{
+		return false;
+	}
+	if (condition && !(Emit(Opcode::toBool) && Emit(pos)))
+	{
+		return false;
+	}
+	return Emit(Opcode::end);
+}
+
+// Compile an expression, stopping before any binary operators with priority 'priority' or lower
+bool ExpressionCompiler::CompileInternal(uint8_t priority) noexcept
+{
+	SkipWhiteSpace();
+	const size_t start = pos;
+	const char c = CurrentCharacter();
+	switch (c)
+	{
+	case '"':
+		if (!ScanQuotedString() || !CompileOperand(start))
+		{
+			return false;
+		}
+		break;
+
+	case '-':
+	case '+':
+	case '!':
+		++pos;
+		if (!CompileInternal(ExpressionParser::UnaryPriority) || !Emit(Opcode::unaryOp) || !Emit(c) || !Emit(pos))
+		{
+			return false;
+		}
+		break;
+
+	case '#':
+		// We only compile # applied to an identifier, which ExpressionParser evaluates as a single operand
+		++pos;
+		SkipWhiteSpace();
+		if (!isalpha(CurrentCharacter()) || !ScanIdentifier() || !CompileOperand(start))
+		{
+			return false;
+		}
+		break;
+
+	case '{':
+	case '(':
+		++pos;
+		if (!CompileInternal(0) || CurrentCharacter() != ((c == '{') ? '}' : ')'))
+		{
+			return false;
+		}
+		++pos;
+		break;
+
+	default:
+		if (isdigit(c))
+		{
+			if (!CompileNumber())
+			{
+				return false;
+			}
+		}
+		else if (!isalpha(c) || !ScanIdentifier() || !CompileOperand(start))
+		{
+			return false;
+		}
+		break;
+	}
+
+	// See if it is followed by a binary operator
+	while (true)
+	{
+		SkipWhiteSpace();
+		char opChar = CurrentCharacter();
+		if (opChar == 0)
+		{
+			return true;
+		}
+
+		const char * const q = strchr(ExpressionParser::BinaryOperators, opChar);
+		if (q == nullptr)
+		{
+			return true;
+		}
+		const uint8_t opPrio = ExpressionParser::BinaryOperatorPriorities[q - ExpressionParser::BinaryOperators];
+		if (opPrio <= priority)
+		{
+			return true;
+		}
+
+		++pos;													// skip the [first] operator character
+
+		// Handle >= and <= and !=
+		bool invert = false;
+		if (opChar == '!')
+		{
+			if (CurrentCharacter() != '=')
+			{
+				return false;
+			}
+			invert = true;
+			++pos;
+			opChar = '=';
+		}
+		else if ((opChar == '>' || opChar == '<') && CurrentCharacter() == '=')
+		{
+			invert = true;
+			++pos;
+			opChar ^= ('>' ^ '<');								// change < to > or vice versa
+		}
+
+		// Allow == && || as alternatives to = & |
+		if ((opChar == '=' || opChar == '&' || opChar == '|') && CurrentCharacter() == opChar)
+		{
+			++pos;
+		}
+
+		switch (opChar)
+		{
+		case '&':
+		case '|':
+			{
+				// The second operand is evaluated only if the first one doesn't decide the result
+				if (!Emit((opChar == '&') ? Opcode::andJump : Opcode::orJump) || !Emit(pos))
+				{
+					return false;
+				}
+				const size_t targetIndex = codeLength;
+				if (!Emit(0))
+				{
+					return false;
+				}
+				Pop();
+				if (!CompileInternal(opPrio) || !Emit(Opcode::toBool) || !Emit(pos))
+				{
+					return false;
+				}
+				code[targetIndex] = codeLength;
+			}
+			break;
+
+		case '?':
+			{
+				if (!Emit(Opcode::condJump) || !Emit(pos))
+				{
+					return false;
+				}
+				const size_t elseTargetIndex = codeLength;
+				if (!Emit(0))
+				{
+					return false;
+				}
+				Pop();
+				if (!CompileInternal(opPrio) || CurrentCharacter() != ':')
+				{
+					return false;
+				}
+				++pos;
+				if (!Emit(Opcode::jump))
+				{
+					return false;
+				}
+				const size_t endTargetIndex = codeLength;
+				if (!Emit(0))
+				{
+					return false;
+				}
+				code[elseTargetIndex] = codeLength;
+				Pop();													// the second operand is not on the stack when we evaluate the third one
+				if (!CompileInternal(opPrio - 1))						// the third operand may be a further conditional expression
+				{
+					return false;
+				}
+				code[endTargetIndex] = codeLength;
+				return true;
+			}
+
+		default:
+			if (!CompileInternal(opPrio) || !Emit(Opcode::binaryOp) || !Emit(opChar) || !Emit(invert) || !Emit(pos))
+			{
+				return false;
+			}
+			Pop();
+			break;
+		}
+	}
+}
+
+// Compile an operand that ExpressionParser will evaluate, from 'start' to the current position
+bool ExpressionCompiler::CompileOperand(size_t start) noexcept
+{
+	return Push() && Emit(Opcode::pushOperand) && Emit(start) && Emit(pos - start);
+}
+
+// Compile a numeric literal in the same way that ExpressionParser::ParseNumber parses it
+bool ExpressionCompiler::CompileNumber() noexcept
+{
+	NumericConverter conv;
+	conv.Accumulate(CurrentCharacter(), NumericConverter::AcceptSignedFloat | NumericConverter::AcceptHex, [this]()->char { ++pos; return CurrentCharacter(); });	// must succeed because CurrentCharacter is a decimal digit
+	if (!Push())
+	{
+		return false;
+	}
+	if (conv.FitsInInt32())
+	{
+		const int32_t ival = conv.GetInt32();
+		return Emit(Opcode::pushInt) && EmitBytes(&ival, sizeof(ival));
+	}
+	const float fval = conv.GetFloat();
+	return Emit(Opcode::pushFloat) && Emit(constrain<unsigned int>(conv.GetDigitsAfterPoint(), 1, MaxFloatDigitsDisplayedAfterPoint)) && EmitBytes(&fval, sizeof(fval));
+}
+
+// Skip a quoted string. Two consecutive double quotes within it stand for one.
+bool ExpressionCompiler::ScanQuotedString() noexcept
+{
+	++pos;															// skip the opening quote
+	while (true)
+	{
+		const char c = CurrentCharacter();
+		if (c == 0)
+		{
+			return false;
+		}
+		++pos;
+		if (c == '"')
+		{
+			if (CurrentCharacter() != '"')
+			{
+				return true;
+			}
+			++pos;
+		}
+	}
+}
+
+// Skip an identifier expression in the same way as ExpressionParser::ParseIdentifierExpression, including any index expressions and function arguments
+bool ExpressionCompiler::ScanIdentifier() noexcept
+{
+	char c;
+	while (isalpha((c = CurrentCharacter())) || isdigit(c) || c == '_' || c == '.' || c == '[')
+	{
+		++pos;
+		if (c == '[' && !ScanBracketed(']'))
+		{
+			return false;
+		}
+	}
+
+	SkipWhiteSpace();
+	if (CurrentCharacter() == '(')
+	{
+		++pos;
+		return ScanBracketed(')');
+	}
+	return true;
+}
+
+// Skip to just after the closing bracket, allowing for nested brackets and quoted strings
+bool ExpressionCompiler::ScanBracketed(char closingBracket) noexcept
+{
+	while (true)
+	{
+		const char c = CurrentCharacter();
+		switch (c)
+		{
+		case 0:
+			return false;
+
+		case '"':
+			if (!ScanQuotedString())
+			{
+				return false;
+			}
+			break;
+
+		case '(':
+		case '[':
+		case '{':
+			++pos;
+			if (!ScanBracketed((c == '(') ? ')' : (c == '[') ? ']' : '}'))
+			{
+				return false;
+			}
+			break;
+
+		default:
+			++pos;
+			if (c == closingBracket)
+			{
+				return true;
+			}
+			if (c == ')' || c == ']' || c == '}')
+			{
+				return false;										// mismatched bracket
+			}
+			break;
+		}
+	}
+}
+
+void ExpressionCompiler::SkipWhiteSpace() noexcept
+{
+	char c;
+	while ((c = CurrentCharacter()) == ' ' || c == '\t')
+	{
+		++pos;
+	}
+}
+
+bool ExpressionCompiler::Emit(uint8_t b) noexcept
+{
+	if (codeLength < CompiledExpression::MaxCodeLength)
+	{
+		code[codeLength++] = b;
+		return true;
+	}
+	return false;
+}
+
+bool ExpressionCompiler::EmitBytes(const void *p, size_t n) noexcept
+{
+	if (codeLength + n <= CompiledExpression::MaxCodeLength)
+	{
+		memcpy(code + codeLength, p, n);
+		codeLength += n;
+		return true;
+	}
+	return false;
+}
+
+bool ExpressionCompiler::Push() noexcept
+{
+	if (depth < CompiledExpression::MaxStackDepth)
+	{
+		++depth;
+		return true;
+	}
+	return false;
+}
+
+// CompiledExpression members
+
+CompiledExpression CompiledExpression::cache[CacheSize];
+uint32_t CompiledExpression::useCounter = 0;
+uint32_t CompiledExpression::missHistory[MissHistorySize] = { 0 };
+size_t CompiledExpression::nextMissToReplace = 0;
+uint32_t CompiledExpression::numCompiledEvaluations = 0;
+uint32_t CompiledExpression::numParsedEvaluations = 0;
+uint32_t CompiledExpression::numCompilations = 0;
+
+// FNV-1a hash of the text
+/*static*/ uint32_t CompiledExpression::Hash(const char *_ecv_array t, size_t length) noexcept
+{
+	uint32_t h = 2166136261u;
+	while (length != 0)
+	{
+		h = (h ^ (uint8_t)*t++) * 16777619u;
+		--length;
+	}
+	return h;
+}
+
+// Return true if we recently parsed an expression with this hash without compiling it, removing it from the history if so; else add it to the history.
+// A hash collision just means that we compile an expression the first time we see it.
+/*static*/ bool CompiledExpression::SeenRecently(uint32_t h) noexcept
+{
+	for (uint32_t& m : missHistory)
+	{
+		if (m == h)
+		{
+			m = 0;
+			return true;
+		}
+	}
+	missHistory[nextMissToReplace] = h;
+	nextMissToReplace = (nextMissToReplace + 1) % MissHistorySize;
+	return false;
+}
+
+bool CompiledExpression::Matches(uint32_t h, const char *_ecv_array t, size_t length, bool condition) const noexcept
+{
+	return h == hash && length == textLength && condition == isCondition && memcmp(t, text, length) == 0;
+}
+
+void CompiledExpression::Compile(uint32_t h, const char *_ecv_array t, size_t length, bool condition) noexcept
+{
+	hash = h;
+	textLength = length;
+	isCondition = condition;
+	memcpy(text, t, length);
+	ExpressionCompiler compiler(text, length, code);
+	valid = compiler.Compile(condition);
+	codeLength = (valid) ? compiler.GetCodeLength() : 0;
+	++numCompilations;
+}
+
+// Return the compiled code for the expression text that runs to the end of the command, or nullptr if it must be parsed instead.
+// If the text isn't in the cache and we parsed it recently then we compile it, replacing the least recently used cache entry. If it can't be compiled then we remember that too.
+/*static*/ const CompiledExpression *_ecv_null CompiledExpression::Find(const char *_ecv_array t, bool condition) noexcept
+{
+	const size_t length = strlen(t);
+	if (length <= MaxTextLength)
+	{
+		const uint32_t h = Hash(t, length);
+		CompiledExpression *_ecv_null ce = nullptr;
+		CompiledExpression *_ecv_null lruEntry = nullptr;
+		for (CompiledExpression& e : cache)
+		{
+			if (e.Matches(h, t, length, condition))
+			{
+				ce = &e;
+				break;
+			}
+			if (lruEntry == nullptr || (int32_t)(e.lastUsed - lruEntry->lastUsed) < 0)
+			{
+				lruEntry = &e;
+			}
+		}
+
+		if (ce == nullptr)
+		{
+			if (!SeenRecently(h ^ (uint32_t)condition))
+			{
+				++numParsedEvaluations;
+				return nullptr;
+			}
+			ce = lruEntry;
+			ce->Compile(h, t, length, condition);
+		}
+
+		ce->lastUsed = ++useCounter;
+		if (ce->valid)
+		{
+			++numCompiledEvaluations;
+			return ce;
+		}
+	}
+
+	++numParsedEvaluations;
+	return nullptr;
+}
+
+// Run the compiled code
+ExpressionValue CompiledExpression::Evaluate(const GCodeBuffer& gb, int column) const THROWS(GCodeException)
+{
+	ExpressionParser parser(gb, text, text + textLength, column);			// we use this to apply operators and to report errors at the right place
+	ExpressionValue stack[MaxStackDepth];
+	size_t sp = 0;
+	size_t pc = 0;
+	while (true)
+	{
+		switch ((Opcode)code[pc])
+		{
+		case Opcode::end:
+			return stack[0];
+
+		case Opcode::pushInt:
+			{
+				int32_t ival;
+				memcpy(&ival, code + pc + 1, sizeof(ival));
+				stack[sp++].Set(ival);
+				pc += 1 + sizeof(ival);
+			}
+			break;
+
+		case Opcode::pushFloat:
+			{
+				float fval;
+				memcpy(&fval, code + pc + 2, sizeof(fval));
+				stack[sp++].Set(fval, code[pc + 1]);
+				pc += 2 + sizeof(fval);
+			}
+			break;
+
+		case Opcode::pushOperand:
+			{
+				const size_t start = code[pc + 1];
+				ExpressionParser operandParser(gb, text + start, text + start + code[pc + 2], (column < 0) ? column : column + (int)start);
+				stack[sp++] = operandParser.Parse();
+				pc += 3;
+			}
+			break;
+
+		case Opcode::unaryOp:
+			parser.SetPosition(code[pc + 2]);
+			parser.ApplyUnaryOperator((char)code[pc + 1], stack[sp - 1], true);
+			pc += 3;
+			break;
+
+		case Opcode::binaryOp:
+			parser.SetPosition(code[pc + 3]);
+			parser.ApplyBinaryOperator((char)code[pc + 1], code[pc + 2] != 0, stack[sp - 2], stack[sp - 1], true);
+			stack[--sp].Release();
+			pc += 4;
+			break;
+
+		case Opcode::toBool:
+			parser.SetPosition(code[pc + 1]);
+			parser.ConvertToBool(stack[sp - 1], true);
+			pc += 2;
+			break;
+
+		case Opcode::andJump:
+		case Opcode::orJump:
+			parser.SetPosition(code[pc + 1]);
+			parser.ConvertToBool(stack[sp - 1], true);
+			if (stack[sp - 1].bVal == ((Opcode)code[pc] == Opcode::orJump))
+			{
+				pc = code[pc + 2];
+			}
+			else
+			{
+				stack[--sp].Release();
+				pc += 3;
+			}
+			break;
+
+		case Opcode::condJump:
+			{
+				parser.SetPosition(code[pc + 1]);
+				parser.ConvertToBool(stack[sp - 1], true);
+				const bool b = stack[sp - 1].bVal;
+				stack[--sp].Release();
+				pc = (b) ? pc + 3 : code[pc + 2];
+			}
+			break;
+
+		case Opcode::jump:
+			pc = code[pc + 1];
+			break;
+
+		default:
+			THROW_INTERNAL_ERROR;
+		}
+	}
+}
+
+/*static*/ void CompiledExpression::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Expressions: %" PRIu32 " compiled evaluations, %" PRIu32 " parsed, %" PRIu32 " compilations\n",
+									numCompiledEvaluations, numParsedEvaluations, numCompilations);
+	numCompiledEvaluations = numParsedEvaluations = numCompilations = 0;
+}
+
+// Compare the speed of evaluating a typical loop condition using compiled code and using ExpressionParser
+/*static*/ void CompiledExpression::TimeEvaluation(const GCodeBuffer& gb, const StringRef& reply) noexcept
+{
+	constexpr unsigned int NumIterations = 100;
+	static const char *_ecv_array const TestExpression = "move.axes[0].userPosition * 2 + 1.5 >= -1000 && (state.upTime + 10) / 2 != 3";
+
+	CompiledExpression ce;
+	ce.Compile(Hash(TestExpression, strlen(TestExpression)), TestExpression, strlen(TestExpression), true);
+	--numCompilations;
+	if (!ce.valid)
+	{
+		reply.copy("Failed to compile test expression");
+		return;
+	}
+
+	try
+	{
+		bool compiledResult = false, parsedResult = false;
+		uint32_t startTicks = StepTimer::GetTimerTicks();
+		for (unsigned int i = 0; i < NumIterations; ++i)
+		{
+			compiledResult = ce.Evaluate(gb, -1).bVal;
+		}
+		const uint32_t compiledTicks = StepTimer::GetTimerTicks() - startTicks;
+
+		startTicks = StepTimer::GetTimerTicks();
+		for (unsigned int i = 0; i < NumIterations; ++i)
+		{
+			ExpressionParser parser(gb, TestExpression, TestExpression + strlen(TestExpression), -1);
+			parsedResult = parser.ParseBoolean();
+		}
+		const uint32_t parsedTicks = StepTimer::GetTimerTicks() - startTicks;
+
+		reply.printf("Evaluations/sec: compiled %.0f, parsed %.0f, %u bytes of code, results %s",
+						(double)((float)NumIterations * (float)StepClockRate/(float)max<uint32_t>(compiledTicks, 1)),
+						(double)((float)NumIterations * (float)StepClockRate/(float)max<uint32_t>(parsedTicks, 1)),
+						ce.codeLength, (compiledResult == parsedResult) ? "agree" : "differ");
+	}
+	catch (const GCodeException& e)
+	{
+		e.GetMessage(reply, nullptr);
+	}
+}
+
+#endif
+
+// End
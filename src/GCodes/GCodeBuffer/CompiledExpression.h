@@ -0,0 +1,78 @@
+/*
+ * CompiledExpression.h
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_GCODES_GCODEBUFFER_COMPILEDEXPRESSION_H_
+#define SRC_GCODES_GCODEBUFFER_COMPILEDEXPRESSION_H_
+
+#include <RepRapFirmware.h>
+#include <ObjectModel/ObjectModel.h>
+#include <GCodes/GCodeException.h>
+
+#if SAME70 || SAME5x
+# define SUPPORT_COMPILED_EXPRESSIONS	(1)		// cache the compiled code for expressions in 'if', 'elif', 'while' and 'set' commands
+#else
+# define SUPPORT_COMPILED_EXPRESSIONS	(0)
+#endif
+
+#if SUPPORT_COMPILED_EXPRESSIONS
+
+// An expression compiled into code for a small stack machine, so that a 'while' loop doesn't have to parse the same text on every iteration.
+// Operators, brackets and numeric literals are compiled. Each operand that needs a lookup or a function call (object model values, variables,
+// named constants, function calls, quoted strings and the # operator applied to them) is compiled into a reference to its text, which is
+// evaluated by ExpressionParser when the code is run. So the code never needs to be invalidated, and operators behave exactly as they do
+// in ExpressionParser because they are applied by the same functions. Expressions that the compiler does not handle are left to ExpressionParser.
+class CompiledExpression
+{
+public:
+	CompiledExpression() noexcept : hash(0), lastUsed(0), textLength(0), codeLength(0), isCondition(false), valid(false) { }
+
+	ExpressionValue Evaluate(const GCodeBuffer& gb, int column) const THROWS(GCodeException);
+
+	// Return the compiled code for the expression text that runs to the end of the command, or nullptr if it must be parsed instead
+	static const CompiledExpression *_ecv_null Find(const char *_ecv_array text, bool condition) noexcept;
+	static void Diagnostics(MessageType mtype) noexcept;
+	static void TimeEvaluation(const GCodeBuffer& gb, const StringRef& reply) noexcept;
+
+	static constexpr size_t MaxTextLength = 100;
+	static constexpr size_t MaxCodeLength = 64;
+	static constexpr size_t MaxStackDepth = 6;
+
+private:
+	bool Matches(uint32_t h, const char *_ecv_array t, size_t length, bool condition) const noexcept;
+	void Compile(uint32_t h, const char *_ecv_array t, size_t length, bool condition) noexcept;
+
+	static uint32_t Hash(const char *_ecv_array t, size_t length) noexcept;
+	static bool SeenRecently(uint32_t h) noexcept;
+
+#if SAME70
+	static constexpr size_t CacheSize = 8;
+#else
+	static constexpr size_t CacheSize = 4;
+#endif
+
+	// We only compile an expression when we see it for the second time, so that commands that are executed only once don't evict expressions
+	// that are used repeatedly. So we keep the hashes of the most recent expressions that we parsed without compiling them.
+	static constexpr size_t MissHistorySize = 2 * CacheSize;
+
+	static CompiledExpression cache[CacheSize];
+	static uint32_t useCounter;
+	static uint32_t missHistory[MissHistorySize];
+	static size_t nextMissToReplace;
+	static uint32_t numCompiledEvaluations, numParsedEvaluations, numCompilations;
+
+	uint32_t hash;
+	uint32_t lastUsed;
+	uint8_t textLength;
+	uint8_t codeLength;
+	bool isCondition;
+	bool valid;
+	char text[MaxTextLength];
+	uint8_t code[MaxCodeLength];
+};
+
+#endif
+
+#endif /* SRC_GCODES_GCODEBUFFER_COMPILEDEXPRESSION_H_ */
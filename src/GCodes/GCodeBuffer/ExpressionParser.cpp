@@ -71,11 +71,7 @@ ExpressionValue ExpressionParser::Parse(bool evaluate) THROWS(GCodeException)
 // This is recursive, so avoid allocating large amounts of data on the stack
 void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_t priority) THROWS(GCodeException)
 {
-	// Lists of binary operators and their priorities
-	static constexpr const char *operators = "?^&|!=<>+-*/";				// for multi-character operators <= and >= and != this is the first character
-	static constexpr uint8_t priorities[] = { 1, 2, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6 };
-	constexpr uint8_t UnaryPriority = 10;									// must be higher than any binary operator priority
-	static_assert(ARRAY_SIZE(priorities) == strlen(operators));
+	static_assert(ARRAY_SIZE(BinaryOperatorPriorities) == strlen(BinaryOperators));
 
 	// Start by looking for a unary operator or opening bracket
 	SkipWhiteSpace();
@@ -87,48 +83,12 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 		break;
 
 	case '-':
-		AdvancePointer();
-		CheckStack(StackUsage::ParseInternal);
-		ParseInternal(val, evaluate, UnaryPriority);
-		switch (val.GetType())
-		{
-		case TypeCode::Int32:
-			val.iVal = -val.iVal;		//TODO overflow check
-			break;
-
-		case TypeCode::Float:
-			val.fVal = -val.fVal;
-			break;
-
-		default:
-			ThrowParseException("expected numeric value after '-'");
-		}
-		break;
-
 	case '+':
+	case '!':
 		AdvancePointer();
 		CheckStack(StackUsage::ParseInternal);
 		ParseInternal(val, evaluate, UnaryPriority);
-		switch (val.GetType())
-		{
-		case TypeCode::Uint32:
-			// Convert enumeration to integer
-			val.iVal = (int32_t)val.uVal;
-			val.SetType(TypeCode::Int32);
-			break;
-
-		case TypeCode::Int32:
-		case TypeCode::Float:
-			break;
-
-		case TypeCode::DateTime_tc:					// unary + converts a DateTime to a seconds count
-			val.iVal = (uint32_t)val.Get56BitValue();
-			val.SetType(TypeCode::Int32);
-			break;
-
-		default:
-			ThrowParseException("expected numeric or enumeration value after '+'");
-		}
+		ApplyUnaryOperator(c, val, evaluate);
 		break;
 
 	case '#':
@@ -169,14 +129,6 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 		ParseExpectKet(val, evaluate, ')');
 		break;
 
-	case '!':
-		AdvancePointer();
-		CheckStack(StackUsage::ParseInternal);
-		ParseInternal(val, evaluate, UnaryPriority);
-		ConvertToBool(val, evaluate);
-		val.bVal = !val.bVal;
-		break;
-
 	default:
 		if (isdigit(c))						// looks like a number
 		{
@@ -204,13 +156,13 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 			return;
 		}
 
-		const char * const q = strchr(operators, opChar);
+		const char * const q = strchr(BinaryOperators, opChar);
 		if (q == nullptr)
 		{
 			return;
 		}
-		const size_t index = q - operators;
-		const uint8_t opPrio = priorities[index];
+		const size_t index = q - BinaryOperators;
+		const uint8_t opPrio = BinaryOperatorPriorities[index];
 		if (opPrio <= priority)
 		{
 			return;
@@ -297,235 +249,296 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 				ExpressionValue val2;
 				CheckStack(StackUsage::ParseInternal);
 				ParseInternal(val2, evaluate, opPrio);	// get the next operand
-				switch(opChar)
-				{
-				case '+':
-					if (val.GetType() == TypeCode::DateTime_tc)
-					{
-						if (val2.GetType() == TypeCode::Uint32)
-						{
-							val.Set56BitValue(val.Get56BitValue() + val2.uVal);
-						}
-						else if (val2.GetType() == TypeCode::Int32)
-						{
-							val.Set56BitValue((int64_t)val.Get56BitValue() + val2.iVal);
-						}
-						else if (evaluate)
-						{
-							ThrowParseException("invalid operand types");
-						}
-					}
-					else
-					{
-						BalanceNumericTypes(val, val2, evaluate);
-						if (val.GetType() == TypeCode::Float)
-						{
-							val.fVal += val2.fVal;
-							val.param = max(val.param, val2.param);
-						}
-						else
-						{
-							val.iVal += val2.iVal;
-						}
-					}
-					break;
+				ApplyBinaryOperator(opChar, invert, val, val2, evaluate);
+			}
+		}
+	} while (true);
+}
 
-				case '-':
-					if (val.GetType() == TypeCode::DateTime_tc)
-					{
-						if (val2.GetType() == TypeCode::DateTime_tc)
-						{
-							// Difference of two data/times
-							val.SetType(TypeCode::Int32);
-							val.iVal = (int32_t)(val.Get56BitValue() - val2.Get56BitValue());
-						}
-						else if (val2.GetType() == TypeCode::Uint32)
-						{
-							val.Set56BitValue(val.Get56BitValue() - val2.uVal);
-						}
-						else if (val2.GetType() == TypeCode::Int32)
-						{
-							val.Set56BitValue((int64_t)val.Get56BitValue() - val2.iVal);
-						}
-						else if (evaluate)
-						{
-							ThrowParseException("invalid operand types");
-						}
-					}
-					else
-					{
-						BalanceNumericTypes(val, val2, evaluate);
-						if (val.GetType() == TypeCode::Float)
-						{
-							val.fVal -= val2.fVal;
-							val.param = max(val.param, val2.param);
-						}
-						else
-						{
-							val.iVal -= val2.iVal;
-						}
-					}
-					break;
+// Apply unary operator '-', '+' or '!' to an operand
+void ExpressionParser::ApplyUnaryOperator(char opChar, ExpressionValue& val, bool evaluate) const THROWS(GCodeException)
+{
+	switch (opChar)
+	{
+	case '-':
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.iVal = -val.iVal;		//TODO overflow check
+			break;
 
-				case '*':
-					BalanceNumericTypes(val, val2, evaluate);
-					if (val.GetType() == TypeCode::Float)
-					{
-						val.fVal *= val2.fVal;
-						val.param = max(val.param, val2.param);
-					}
-					else
-					{
-						val.iVal *= val2.iVal;
-					}
-					break;
+		case TypeCode::Float:
+			val.fVal = -val.fVal;
+			break;
 
-				case '/':
-					ConvertToFloat(val, evaluate);
-					ConvertToFloat(val2, evaluate);
-					val.fVal /= val2.fVal;
-					val.param = MaxFloatDigitsDisplayedAfterPoint;
-					break;
+		default:
+			ThrowParseException("expected numeric value after '-'");
+		}
+		break;
 
-				case '>':
-					BalanceTypes(val, val2, evaluate);
-					switch (val.GetType())
-					{
-					case TypeCode::Int32:
-						val.bVal = (val.iVal > val2.iVal);
-						break;
+	case '+':
+		switch (val.GetType())
+		{
+		case TypeCode::Uint32:
+			// Convert enumeration to integer
+			val.iVal = (int32_t)val.uVal;
+			val.SetType(TypeCode::Int32);
+			break;
 
-					case TypeCode::Float:
-						val.bVal = (val.fVal > val2.fVal);
-						break;
+		case TypeCode::Int32:
+		case TypeCode::Float:
+			break;
 
-					case TypeCode::DateTime_tc:
-						val.bVal = val.Get56BitValue() > val2.Get56BitValue();
-						break;
+		case TypeCode::DateTime_tc:					// unary + converts a DateTime to a seconds count
+			val.iVal = (uint32_t)val.Get56BitValue();
+			val.SetType(TypeCode::Int32);
+			break;
 
-					case TypeCode::Bool:
-						val.bVal = (val.bVal && !val2.bVal);
-						break;
+		default:
+			ThrowParseException("expected numeric or enumeration value after '+'");
+		}
+		break;
 
-					default:
-						if (evaluate)
-						{
-							ThrowParseException("expected numeric or Boolean operands to comparison operator");
-						}
-						val.bVal = false;
-						break;
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+	case '!':
+		ConvertToBool(val, evaluate);
+		val.bVal = !val.bVal;
+		break;
 
-				case '<':
-					BalanceTypes(val, val2, evaluate);
-					switch (val.GetType())
-					{
-					case TypeCode::Int32:
-						val.bVal = (val.iVal < val2.iVal);
-						break;
+	default:
+		THROW_INTERNAL_ERROR;
+	}
+}
 
-					case TypeCode::Float:
-						val.bVal = (val.fVal < val2.fVal);
-						break;
+// Apply a binary operator that always evaluates both operands, assigning the result to the first operand.
+// Comparison operators >= and <= and != are passed as the inverse operator with 'invert' set.
+void ExpressionParser::ApplyBinaryOperator(char opChar, bool invert, ExpressionValue& val, ExpressionValue& val2, bool evaluate) THROWS(GCodeException)
+{
+	switch (opChar)
+	{
+	case '+':
+		if (val.GetType() == TypeCode::DateTime_tc)
+		{
+			if (val2.GetType() == TypeCode::Uint32)
+			{
+				val.Set56BitValue(val.Get56BitValue() + val2.uVal);
+			}
+			else if (val2.GetType() == TypeCode::Int32)
+			{
+				val.Set56BitValue((int64_t)val.Get56BitValue() + val2.iVal);
+			}
+			else if (evaluate)
+			{
+				ThrowParseException("invalid operand types");
+			}
+		}
+		else
+		{
+			BalanceNumericTypes(val, val2, evaluate);
+			if (val.GetType() == TypeCode::Float)
+			{
+				val.fVal += val2.fVal;
+				val.param = max(val.param, val2.param);
+			}
+			else
+			{
+				val.iVal += val2.iVal;
+			}
+		}
+		break;
 
-					case TypeCode::DateTime_tc:
-						val.bVal = val.Get56BitValue() < val2.Get56BitValue();
-						break;
+	case '-':
+		if (val.GetType() == TypeCode::DateTime_tc)
+		{
+			if (val2.GetType() == TypeCode::DateTime_tc)
+			{
+				// Difference of two data/times
+				val.SetType(TypeCode::Int32);
+				val.iVal = (int32_t)(val.Get56BitValue() - val2.Get56BitValue());
+			}
+			else if (val2.GetType() == TypeCode::Uint32)
+			{
+				val.Set56BitValue(val.Get56BitValue() - val2.uVal);
+			}
+			else if (val2.GetType() == TypeCode::Int32)
+			{
+				val.Set56BitValue((int64_t)val.Get56BitValue() - val2.iVal);
+			}
+			else if (evaluate)
+			{
+				ThrowParseException("invalid operand types");
+			}
+		}
+		else
+		{
+			BalanceNumericTypes(val, val2, evaluate);
+			if (val.GetType() == TypeCode::Float)
+			{
+				val.fVal -= val2.fVal;
+				val.param = max(val.param, val2.param);
+			}
+			else
+			{
+				val.iVal -= val2.iVal;
+			}
+		}
+		break;
 
-					case TypeCode::Bool:
-						val.bVal = (!val.bVal && val2.bVal);
-						break;
+	case '*':
+		BalanceNumericTypes(val, val2, evaluate);
+		if (val.GetType() == TypeCode::Float)
+		{
+			val.fVal *= val2.fVal;
+			val.param = max(val.param, val2.param);
+		}
+		else
+		{
+			val.iVal *= val2.iVal;
+		}
+		break;
 
-					default:
-						if (evaluate)
-						{
-							ThrowParseException("expected numeric or Boolean operands to comparison operator");
-						}
-						val.bVal = false;
-						break;
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+	case '/':
+		ConvertToFloat(val, evaluate);
+		ConvertToFloat(val2, evaluate);
+		val.fVal /= val2.fVal;
+		val.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
 
-				case '=':
-					// Before balancing, handle comparisons with null
-					if (val.GetType() == TypeCode::None)
-					{
-						val.bVal = (val2.GetType() == TypeCode::None);
-					}
-					else if (val2.GetType() == TypeCode::None)
-					{
-						val.bVal = false;
-					}
-					else
-					{
-						BalanceTypes(val, val2, evaluate);
-						switch (val.GetType())
-						{
-						case TypeCode::ObjectModel_tc:
-							ThrowParseException("cannot compare objects");
-
-						case TypeCode::Int32:
-							val.bVal = (val.iVal == val2.iVal);
-							break;
-
-						case TypeCode::Uint32:
-							val.bVal = (val.uVal == val2.uVal);
-							break;
-
-						case TypeCode::Float:
-							val.bVal = (val.fVal == val2.fVal);
-							break;
-
-						case TypeCode::DateTime_tc:
-							val.bVal = val.Get56BitValue() == val2.Get56BitValue();
-							break;
-
-						case TypeCode::Bool:
-							val.bVal = (val.bVal == val2.bVal);
-							break;
-
-						case TypeCode::CString:
-							val.bVal = (strcmp(val.sVal, (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
-							break;
-
-						case TypeCode::HeapString:
-							val.bVal = (strcmp(val.shVal.Get().Ptr(), (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
-							break;
-
-						default:
-							if (evaluate)
-							{
-								ThrowParseException("unexpected operand type to equality operator");
-							}
-							val.bVal = false;
-							break;
-						}
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+	case '>':
+		BalanceTypes(val, val2, evaluate);
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.bVal = (val.iVal > val2.iVal);
+			break;
 
-				case '^':
-					StringConcat(val, val2);
-					break;
+		case TypeCode::Float:
+			val.bVal = (val.fVal > val2.fVal);
+			break;
+
+		case TypeCode::DateTime_tc:
+			val.bVal = val.Get56BitValue() > val2.Get56BitValue();
+			break;
+
+		case TypeCode::Bool:
+			val.bVal = (val.bVal && !val2.bVal);
+			break;
+
+		default:
+			if (evaluate)
+			{
+				ThrowParseException("expected numeric or Boolean operands to comparison operator");
+			}
+			val.bVal = false;
+			break;
+		}
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '<':
+		BalanceTypes(val, val2, evaluate);
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.bVal = (val.iVal < val2.iVal);
+			break;
+
+		case TypeCode::Float:
+			val.bVal = (val.fVal < val2.fVal);
+			break;
+
+		case TypeCode::DateTime_tc:
+			val.bVal = val.Get56BitValue() < val2.Get56BitValue();
+			break;
+
+		case TypeCode::Bool:
+			val.bVal = (!val.bVal && val2.bVal);
+			break;
+
+		default:
+			if (evaluate)
+			{
+				ThrowParseException("expected numeric or Boolean operands to comparison operator");
+			}
+			val.bVal = false;
+			break;
+		}
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '=':
+		// Before balancing, handle comparisons with null
+		if (val.GetType() == TypeCode::None)
+		{
+			val.bVal = (val2.GetType() == TypeCode::None);
+		}
+		else if (val2.GetType() == TypeCode::None)
+		{
+			val.bVal = false;
+		}
+		else
+		{
+			BalanceTypes(val, val2, evaluate);
+			switch (val.GetType())
+			{
+			case TypeCode::ObjectModel_tc:
+				ThrowParseException("cannot compare objects");
+
+			case TypeCode::Int32:
+				val.bVal = (val.iVal == val2.iVal);
+				break;
+
+			case TypeCode::Uint32:
+				val.bVal = (val.uVal == val2.uVal);
+				break;
+
+			case TypeCode::Float:
+				val.bVal = (val.fVal == val2.fVal);
+				break;
+
+			case TypeCode::DateTime_tc:
+				val.bVal = val.Get56BitValue() == val2.Get56BitValue();
+				break;
+
+			case TypeCode::Bool:
+				val.bVal = (val.bVal == val2.bVal);
+				break;
+
+			case TypeCode::CString:
+				val.bVal = (strcmp(val.sVal, (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
+				break;
+
+			case TypeCode::HeapString:
+				val.bVal = (strcmp(val.shVal.Get().Ptr(), (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
+				break;
+
+			default:
+				if (evaluate)
+				{
+					ThrowParseException("unexpected operand type to equality operator");
 				}
+				val.bVal = false;
+				break;
 			}
 		}
-	} while (true);
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '^':
+		StringConcat(val, val2);
+		break;
+	}
 }
 
 // Concatenate val1 and val2 and assign the result to val1
@@ -1322,6 +1335,7 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 
 		// Else assume an object model value
 		CheckStack(StackUsage::GetObjectValueUsingTableNumber);
+		context.SetCachedPath(ObjectModelPathCache::Find(id.c_str()));
 		rslt = reprap.GetObjectValueUsingTableNumber(context, nullptr, id.c_str(), 0);
 		if (context.ObsoleteFieldQueried() && obsoleteField.IsEmpty())
 		{
@@ -36,7 +36,14 @@ public:
 	void CheckForExtraCharacters() THROWS(GCodeException);
 	const char *GetEndptr() const noexcept { return currentp; }
 
+	// Binary operators and their priorities. For multi-character operators <= and >= and != this is the first character.
+	static constexpr const char *_ecv_array BinaryOperators = "?^&|!=<>+-*/";
+	static constexpr uint8_t BinaryOperatorPriorities[] = { 1, 2, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6 };
+	static constexpr uint8_t UnaryPriority = 10;						// must be higher than any binary operator priority
+
 private:
+	friend class CompiledExpression;									// this applies operators and conversions when running compiled expressions
+
 	[[noreturn]] void __attribute__((noinline)) ThrowParseException(const char *str) const THROWS(GCodeException);
 	[[noreturn]] void __attribute__((noinline)) ThrowParseException(const char *str, const char *param) const THROWS(GCodeException);
 	[[noreturn]] void __attribute__((noinline)) ThrowParseException(const char *str, uint32_t param) const THROWS(GCodeException);
@@ -49,6 +56,9 @@ private:
 		pre(readPointer >= 0; isalpha(gb.buffer[readPointer]));
 	void __attribute__((noinline)) ParseQuotedString(ExpressionValue& rslt) THROWS(GCodeException);
 
+	void ApplyUnaryOperator(char opChar, ExpressionValue& val, bool evaluate) const THROWS(GCodeException);
+	void __attribute__((noinline)) ApplyBinaryOperator(char opChar, bool invert, ExpressionValue& val, ExpressionValue& val2, bool evaluate) THROWS(GCodeException);
+
 	void ParseArray(size_t& length, function_ref<void(size_t index) THROWS(GCodeException)> processElement) THROWS(GCodeException);
 	time_t ParseDateTime(const char *s) const THROWS(GCodeException);
 
@@ -71,6 +81,7 @@ private:
 	int GetColumn() const noexcept;
 	char CurrentCharacter() const noexcept;
 	void AdvancePointer() noexcept { ++currentp; }		// could check that we havebn't reached endp but we should stop before that happens
+	void SetPosition(size_t offset) noexcept { currentp = startp + offset; }
 
 	const char *currentp;
 	const char * const startp;
@@ -352,6 +352,19 @@ bool GCodeBuffer::SeenAny(Bitmap<uint32_t> bm) const noexcept
 	return PARSER_OPERATION(SeenAny(bm));
 }
 
+// Time finding and looking up the parameters of the current command
+void GCodeBuffer::TimeParsing(const StringRef& reply) noexcept
+{
+#if HAS_SBC_INTERFACE
+	if (isBinaryBuffer)
+	{
+		reply.copy("Command was received in binary format so it was not parsed");
+		return;
+	}
+#endif
+	stringParser.TimeParsing(reply);
+}
+
 // Test for character present, throw error if not
 void GCodeBuffer::MustSee(char c) THROWS(GCodeException)
 {
@@ -10,11 +10,13 @@
 #include "StringParser.h"
 #include "GCodeBuffer.h"
 #include "ExpressionParser.h"
+#include "CompiledExpression.h"
 
 #include <GCodes/GCodes.h>
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
 #include <Networking/NetworkDefs.h>
+#include <Movement/StepTimer.h>
 
 // Replace the default definition of THROW_INTERNAL_ERROR by one that gives line information
 #undef THROW_INTERNAL_ERROR
@@ -39,6 +41,7 @@ void StringParser::Init() noexcept
 	readPointer = -1;
 	hadLineNumber = hadChecksum = overflowed = seenExpression = false;
 	computedChecksum = 0;
+	memset(parameterOffsets, 0, sizeof(parameterOffsets));
 	gb.bufferState = GCodeBufferState::parseNotStarted;
 	commandIndent = 0;
 	if (!seenMetaCommand)
@@ -746,9 +749,19 @@ void StringParser::ProcessSetCommand() THROWS(GCodeException)
 	}
 
 	SkipWhiteSpace();
-	ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
-	ExpressionValue ev = parser.Parse();
-	var->Assign(ev);
+#if SUPPORT_COMPILED_EXPRESSIONS
+	const CompiledExpression *_ecv_null const ce = CompiledExpression::Find(gb.buffer + readPointer, false);
+	if (ce != nullptr)
+	{
+		var->Assign(ce->Evaluate(gb, commandIndent + readPointer));
+	}
+	else
+#endif
+	{
+		ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+		ExpressionValue ev = parser.Parse();
+		var->Assign(ev);
+	}
 	if (isGlobal)
 	{
 		reprap.GlobalUpdated();
@@ -862,6 +875,13 @@ void StringParser::ProcessEchoCommand(const StringRef& reply) THROWS(GCodeExcept
 // Evaluate the condition that should follow 'if' or 'while'
 bool StringParser::EvaluateCondition() THROWS(GCodeException)
 {
+#if SUPPORT_COMPILED_EXPRESSIONS
+	const CompiledExpression *_ecv_null const ce = CompiledExpression::Find(gb.buffer + readPointer, true);
+	if (ce != nullptr)
+	{
+		return ce->Evaluate(gb, commandIndent + readPointer).bVal;
+	}
+#endif
 	ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
 	const bool b = parser.ParseBoolean();
 	parser.CheckForExtraCharacters();
@@ -874,6 +894,8 @@ bool StringParser::EvaluateCondition() THROWS(GCodeException)
 // On return, the state must be set to 'ready' to indicate that a command is available and we should stop adding characters.
 void StringParser::DecodeCommand() noexcept
 {
+	memset(parameterOffsets, 0, sizeof(parameterOffsets));
+
 	// Check for a valid command letter at the start
 	char cl = gb.buffer[commandStart];
 	if (cl == '\'')									// check for a lowercase axis letter in Fanuc mode
@@ -981,6 +1003,7 @@ void StringParser::DecodeCommand() noexcept
 
 // Find where the end of the command is. We assume that a G or M not inside quotes or { } and not preceded by ' is the start of a new command.
 // This isn't true if the command has an unquoted string argument, but we deal with that later.
+// While we are doing this, record where each parameter letter first occurs so that Seen() doesn't need to search the command again.
 void StringParser::FindParameters() noexcept
 {
 	bool inQuotes = false;
@@ -1016,6 +1039,13 @@ void StringParser::FindParameters() noexcept
 				if (c2 >= 'A' && c2 <= 'Z' && (c2 != 'E' || commandEnd == parameterStart || !isdigit(gb.buffer[commandEnd - 1])))
 				{
 					parametersPresent.SetBit(c2 - 'A');
+					if (   parameterOffsets[c2 - 'A'] == 0
+						&& (commandEnd == parameterStart || gb.buffer[commandEnd - 1] != '\'')
+						&& commandEnd - parameterStart < UINT8_MAX
+					   )
+					{
+						parameterOffsets[c2 - 'A'] = (uint8_t)(commandEnd - parameterStart + 1);
+					}
 				}
 			}
 		}
@@ -1106,16 +1136,33 @@ bool StringParser::IsLastCommand() const noexcept
 // Leave the pointer one after it for a subsequent read.
 bool StringParser::Seen(char c) noexcept
 {
-	bool wantLowerCase = (c >= 'a');
+	const bool wantLowerCase = (c >= 'a');
 	if (wantLowerCase)
 	{
 		c = toupper(c);
 	}
-	else if (!parametersPresent.IsBitSet(c - 'A'))
+	else
 	{
-		return false;
+		if (!parametersPresent.IsBitSet(c - 'A'))
+		{
+			return false;
+		}
+
+		const unsigned int offset = parameterOffsets[c - 'A'];
+		if (offset != 0)
+		{
+			readPointer = parameterStart + offset;							// one after the parameter letter
+			return true;
+		}
 	}
 
+	return SeenByScanning(c, wantLowerCase);
+}
+
+// Search the command for parameter 'c', which is in upper case. If wantLowerCase is true then we are looking for the escaped lowercase version.
+// Leave the pointer one after it for a subsequent read.
+bool StringParser::SeenByScanning(char c, bool wantLowerCase) noexcept
+{
 	bool inQuotes = false;
 	bool escaped = false;
 	unsigned int inBrackets = 0;
@@ -1165,6 +1212,44 @@ bool StringParser::SeenAny(Bitmap<uint32_t> bm) const noexcept
 	return parametersPresent.Intersects(bm);
 }
 
+// Time how long it takes to find the parameters of the current command and look up each of them, with and without the index of parameter positions.
+// For example, M122 P113 X10 Y20 Z0.3 E1.5 F3000 times a command with the same parameters as a typical extruding move.
+void StringParser::TimeParsing(const StringRef& reply) noexcept
+{
+	constexpr unsigned int NumIterations = 1000;
+	const int savedReadPointer = readPointer;
+	unsigned int numFound = 0;
+
+	uint32_t startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumIterations; ++i)
+	{
+		FindParameters();
+		parametersPresent.Iterate([this, &numFound](unsigned int bit, unsigned int) noexcept
+									{
+										if (Seen((char)('A' + bit))) { ++numFound; }
+									});
+	}
+	const uint32_t indexedTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumIterations; ++i)
+	{
+		FindParameters();
+		parametersPresent.Iterate([this, &numFound](unsigned int bit, unsigned int) noexcept
+									{
+										if (SeenByScanning((char)('A' + bit), false)) { ++numFound; }
+									});
+	}
+	const uint32_t scanningTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	readPointer = savedReadPointer;
+	reply.printf("Command with %u parameters: indexed %.0f lines/sec, scanning %.0f lines/sec, %u lookups",
+					parametersPresent.CountSetBits(),
+					(double)((float)NumIterations * (float)StepClockRate/(float)max<uint32_t>(indexedTicks, 1)),
+					(double)((float)NumIterations * (float)StepClockRate/(float)max<uint32_t>(scanningTicks, 1)),
+					numFound);
+}
+
 // Get a float after a G Code letter found by a call to Seen()
 float StringParser::GetFValue() THROWS(GCodeException)
 {
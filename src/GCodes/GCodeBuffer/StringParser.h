@@ -46,6 +46,7 @@ public:
 
 	bool Seen(char c) noexcept SPEED_CRITICAL;									// Is a character present?
 	bool SeenAny(Bitmap<uint32_t> bm) const noexcept;							// Return true if any of the parameter letters in the bitmap were seen
+	void TimeParsing(const StringRef& reply) noexcept;							// Time finding and looking up the parameters of the current command
 	float GetFValue() THROWS(GCodeException) SPEED_CRITICAL;					// Get a float after a key letter
 	float GetDistance() THROWS(GCodeException) SPEED_CRITICAL;					// Get a distance or coordinate and convert it from inches to mm if necessary
 	int32_t GetIValue() THROWS(GCodeException) SPEED_CRITICAL;					// Get an integer after a key letter
@@ -124,6 +125,7 @@ private:
 
 	void SkipWhiteSpace() noexcept;
 	void FindParameters() noexcept;
+	bool SeenByScanning(char c, bool wantLowerCase) noexcept;
 
 	unsigned int commandStart;							// Index in the buffer of the command letter of this command
 	unsigned int parameterStart;
@@ -132,6 +134,7 @@ private:
 	unsigned int braceCount;							// how many nested { } we are inside
 	unsigned int gcodeLineEnd;							// Number of characters in the entire line of gcode
 	Bitmap<uint32_t> parametersPresent;					// which parameters are present in this command
+	uint8_t parameterOffsets[26];						// for each uppercase parameter letter, 1 + the offset from parameterStart of its first occurrence, or 0 if not known
 	int readPointer;									// Where in the buffer to read next, or -1
 
 	FileStore *fileBeingWritten;						// If we are copying GCodes to a file, which file it is
@@ -10,8 +10,9 @@
 #include <Platform/RepRap.h>
 #include "GCodes.h"
 #include "GCodeBuffer/GCodeBuffer.h"
+#include <Storage/MassStorage.h>
+#include <Movement/StepTimer.h>
 
-const size_t GCodeInputFileReadThreshold = 128;		// How many free bytes must be available before data is read from the file
 const size_t GCodeInputUSBReadThreshold = 128;		// How many free bytes must be available before we read more data from USB
 
 // Read some input bytes into the GCode buffer. Return true if there is a line of GCode waiting to be processed.
@@ -250,11 +251,19 @@ bool NetworkGCodeInput::FillBuffer(GCodeBuffer *gb) noexcept /*override*/
 
 // File-based G-code input source
 
+// Static storage for the file input buffer. On the SAME70 the SD card interface writes into it using DMA, so it must not be cached.
+alignas(4) static __nocache char fileInputBuffer[FileGCodeInputBufferSize];
+
+FileGCodeInput::FileGCodeInput() noexcept
+	: buffer(fileInputBuffer), writingPointer(0), readingPointer(0), bytesCached(0)
+{
+}
+
 // Reset this input. Should be called when the associated file is being closed
 void FileGCodeInput::Reset() noexcept
 {
 	lastFileRead.Close();
-	RegularGCodeInput::Reset();
+	writingPointer = readingPointer = bytesCached = 0;
 }
 
 // Reset this input. Should be called when a specific G-code or macro file is closed outside of the reading context
@@ -266,11 +275,59 @@ void FileGCodeInput::Reset(const FileData &file) noexcept
 	}
 }
 
+inline void FileGCodeInput::ConsumeBytes(size_t numBytes) noexcept
+{
+	readingPointer = (readingPointer + numBytes) % FileGCodeInputBufferSize;
+	bytesCached -= numBytes;
+}
+
+char FileGCodeInput::ReadByte() noexcept
+{
+	const char c = buffer[readingPointer];
+	ConsumeBytes(1);
+	return c;
+}
+
+// Read some input bytes into the GCode buffer. Return true if there is a line of GCode waiting to be processed.
+// This scans the cached data in place one contiguous span at a time, instead of fetching each character through ReadByte.
+bool FileGCodeInput::FillBuffer(GCodeBuffer *gb) noexcept
+{
+#if HAS_MASS_STORAGE
+	if (gb->IsWritingBinary())
+	{
+		return StandardGCodeInput::FillBuffer(gb);
+	}
+#endif
+
+	while (bytesCached != 0)
+	{
+		const char *_ecv_array const span = buffer + readingPointer;
+		const size_t spanLength = min<size_t>(bytesCached, FileGCodeInputBufferSize - readingPointer);
+		size_t i = 0;
+		while (i < spanLength)
+		{
+			if (gb->Put(span[i++]))				// process a character, returns true if a line of GCode is complete
+			{
+#if HAS_MASS_STORAGE
+				if (gb->IsWritingFile())
+				{
+					gb->WriteToFile();
+					continue;
+				}
+#endif
+				ConsumeBytes(i);
+				return true;					// a line of GCode is complete, so stop here
+			}
+		}
+		ConsumeBytes(spanLength);
+	}
+
+	return false;
+}
+
 // Read another chunk of G-codes from the file and return true if more data is available
 GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 {
-	const size_t bytesCached = BytesCached();
-
 	// Keep track of the last file we read from
 	if (lastFileRead.IsLive() && lastFileRead != file)
 	{
@@ -281,32 +338,39 @@ GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 			lastFileRead.Seek(lastFileRead.GetPosition() - bytesCached);
 		}
 
-		RegularGCodeInput::Reset();
+		writingPointer = readingPointer = bytesCached = 0;
 	}
 	lastFileRead.CopyFrom(file);
 
-	// Read more from the file
-	if (bytesCached < GCodeInputFileReadThreshold)
+	// If the buffer is empty then realign it with the file, so that block reads start on block boundaries in both
+	if (bytesCached == 0)
 	{
-		// Reset the read+write pointers for better performance if possible
-		if (readingPointer == writingPointer)
-		{
-			readingPointer = writingPointer = 0;
-		}
+		writingPointer = readingPointer = (size_t)(file.GetPosition() % FileGCodeInputBufferSize);
+	}
+
+	// Read up to the next block boundary if we are not on one, otherwise read as many whole blocks as there is contiguous space for
+	size_t bytesToRead = min<size_t>(FileGCodeInputBufferSize - writingPointer, FileGCodeInputBufferSize - bytesCached);
+	const size_t offsetInBlock = writingPointer % FileGCodeInputReadBlockSize;
+	if (offsetInBlock != 0)
+	{
+		bytesToRead = min<size_t>(bytesToRead, FileGCodeInputReadBlockSize - offsetInBlock);
+	}
+	else
+	{
+		bytesToRead -= bytesToRead % FileGCodeInputReadBlockSize;
+	}
 
-		// The code here used to read into a local buffer in blocks that are multiples of 4 bytes.
-		// However, unless we can use a buffer of at least 512 bytes then that is redundant,
-		// because the data will be copied via the sector buffer in FatFS anyway. So we don't do that any more.
-		const int bytesRead = file.Read(buffer + writingPointer, min<size_t>(BufferSpaceLeft(), GCodeInputBufferSize - writingPointer));
+	if (bytesToRead != 0)
+	{
+		const uint32_t startTime = StepTimer::GetTimerTicks();
+		const int bytesRead = file.Read(buffer + writingPointer, bytesToRead);
 		if (bytesRead < 0)
 		{
 			return GCodeInputReadResult::error;
 		}
-		if (bytesRead > 0)
-		{
-			writingPointer = (writingPointer + (size_t)bytesRead) % GCodeInputBufferSize;
-			return GCodeInputReadResult::haveData;
-		}
+		MassStorage::RecordFileInputRead((size_t)bytesRead, StepTimer::GetTimerTicks() - startTime);
+		writingPointer = (writingPointer + (size_t)bytesRead) % FileGCodeInputBufferSize;
+		bytesCached += (size_t)bytesRead;
 	}
 
 	return (bytesCached > 0) ? GCodeInputReadResult::haveData : GCodeInputReadResult::noData;
@@ -103,21 +103,47 @@ enum class GCodeInputReadResult : uint8_t { haveData, noData, error };
 
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 
-// This class is an expansion of the RegularGCodeInput class to buffer G-codes and to rewind file positions when
-// nested G-code files are started. However buffered codes are not explicitly checked for M112.
-class FileGCodeInput : public RegularGCodeInput
+#if SAME70 || SAME5x
+# define FILE_INPUT_SECTOR_READS	(1)						// read G-code files in whole SD card sectors directly into the input buffer
+#else
+# define FILE_INPUT_SECTOR_READS	(0)
+#endif
+
+#if FILE_INPUT_SECTOR_READS
+const size_t FileGCodeInputReadBlockSize = 512;					// must equal the SD card sector size so that FatFS can bypass its sector buffer
+#else
+const size_t FileGCodeInputReadBlockSize = GCodeInputBufferSize/2;
+#endif
+const size_t FileGCodeInputBufferSize = 2 * FileGCodeInputReadBlockSize;
+
+// This class buffers G-codes read from files and rewinds file positions when nested G-code files are started.
+// The buffer is used as two halves. The buffer index at which the next byte is stored always equals the file position modulo the buffer size,
+// so after the first partial read every read starts on a block boundary in both the file and the buffer. When the block size is the sector size,
+// FatFS transfers whole sectors straight into the buffer instead of copying them via its sector buffer, and each half is refilled as soon as it
+// has been consumed while the G-code in the other half is still being processed. Buffered codes are not checked for M112.
+// There is only one instance of this class because the buffer storage is static, so that on the SAME70 it can be placed in non-cached memory for DMA.
+class FileGCodeInput : public StandardGCodeInput
 {
 public:
 
-	FileGCodeInput() noexcept : RegularGCodeInput() { }
+	FileGCodeInput() noexcept;
 
 	void Reset() noexcept override;								// Clears the buffer. Should be called when the associated file is being closed
 	void Reset(const FileData &file) noexcept;					// Clears the buffer of a specific file. Should be called when it is closed or re-opened outside the reading context
+	bool FillBuffer(GCodeBuffer *gb) noexcept override;			// Fill a GCodeBuffer with the last available G-code
+	size_t BytesCached() const noexcept override { return bytesCached; }
 
 	GCodeInputReadResult ReadFromFile(FileData &file) noexcept;	// Read another chunk of G-codes from the file and return true if more data is available
 
+protected:
+	char ReadByte() noexcept override;
+
 private:
+	void ConsumeBytes(size_t numBytes) noexcept;
+
 	FileData lastFileRead;
+	char *_ecv_array const buffer;
+	size_t writingPointer, readingPointer, bytesCached;
 };
 
 #endif
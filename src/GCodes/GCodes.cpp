@@ -26,6 +26,7 @@
 #include "GCodes.h"
 
 #include "GCodeBuffer/GCodeBuffer.h"
+#include "GCodeBuffer/CompiledExpression.h"
 #include "GCodeQueue.h"
 #include <Heating/Heat.h>
 #include <Platform/Platform.h>
@@ -1406,6 +1407,12 @@ void GCodes::Diagnostics(MessageType mtype) noexcept
 	}
 
 	codeQueue->Diagnostics(mtype);
+#if SUPPORT_OBJECT_MODEL
+	ObjectModelPathCache::Diagnostics(mtype);
+#endif
+#if SUPPORT_COMPILED_EXPRESSIONS
+	CompiledExpression::Diagnostics(mtype);
+#endif
 }
 
 // Lock movement and wait for pending moves to finish.
@@ -2680,7 +2687,7 @@ bool GCodes::DoFileMacro(GCodeBuffer& gb, const char* fileName, bool reportMissi
 #endif
 	{
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
-		FileStore * const f = platform.OpenSysFile(fileName, OpenMode::read);
+		FileStore * const f = platform.OpenSysFile(fileName, OpenMode::readCached);
 		if (f == nullptr)
 		{
 			if (reportMissing)
@@ -3019,8 +3026,9 @@ GCodeResult GCodes::LoadHeightMap(GCodeBuffer& gb, const StringRef& reply)
 	return GCodeResult::ok;
 }
 
-// Save the height map and append the success or error message to 'reply', returning true if an error occurred
-bool GCodes::TrySaveHeightMap(const char *filename, const StringRef& reply) const noexcept
+// Save the height map and append the success or error message to 'reply', returning true if an error occurred.
+// If 'map' is null then we save the height map in use, else we save 'map' without any Z shift. The file format depends on the file name.
+bool GCodes::TrySaveHeightMap(const char *filename, const StringRef& reply, HeightMap *_ecv_null map) const noexcept
 {
 	String<MaxFilenameLength> fullName;
 	platform.MakeSysFileName(fullName.GetRef(), filename);
@@ -3033,7 +3041,7 @@ bool GCodes::TrySaveHeightMap(const char *filename, const StringRef& reply) cons
 	}
 	else
 	{
-		err = reprap.GetMove().SaveHeightMapToFile(f, fullName.c_str());
+		err = (map == nullptr) ? reprap.GetMove().SaveHeightMapToFile(f, fullName.c_str()) : map->SaveToFile(f, fullName.c_str(), 0.0);
 		f->Close();
 		if (err)
 		{
@@ -3061,6 +3069,59 @@ GCodeResult GCodes::SaveHeightMap(GCodeBuffer& gb, const StringRef& reply) const
 	return GetGCodeResultFromError(TrySaveHeightMap(DefaultHeightMapFile, reply));
 }
 
+// Load the height map from the file specified by the P parameter and save it to the file specified by the Q parameter.
+// The format of the saved file depends on its extension, so this converts between CSV and binary height maps.
+// If there is no Q parameter then we convert a CSV file to the default binary file or a binary file to the default CSV file.
+// The conversion uses a temporary height map, so it doesn't change the height map in use or whether bed compensation is enabled.
+GCodeResult GCodes::ConvertHeightMap(GCodeBuffer& gb, const StringRef& reply)
+{
+	String<MaxFilenameLength> heightMapFileName;
+	bool seen = false;
+	gb.TryGetQuotedString('P', heightMapFileName.GetRef(), seen);
+	if (!seen)
+	{
+		heightMapFileName.copy(DefaultHeightMapFile);
+	}
+
+	String<MaxFilenameLength> destFileName;
+	seen = false;
+	gb.TryGetQuotedString('Q', destFileName.GetRef(), seen);
+	if (!seen)
+	{
+		destFileName.copy((HeightMap::IsBinaryFileName(heightMapFileName.c_str())) ? DefaultHeightMapFile : DefaultBinaryHeightMapFile);
+	}
+
+	// A height map is too large to put on the stack, so allocate it temporarily if there is enough memory
+	const ptrdiff_t memoryNeeded = sizeof(HeightMap) + 1024;					// allow some margin
+	const ptrdiff_t memoryAvailable = Tasks::GetNeverUsedRam();
+	if (memoryNeeded >= memoryAvailable)
+	{
+		reply.printf("insufficient RAM to convert height map (available %d, needed %d)", memoryAvailable, memoryNeeded);
+		return GCodeResult::error;
+	}
+
+	String<MaxFilenameLength> fullName;
+	platform.MakeSysFileName(fullName.GetRef(), heightMapFileName.c_str());
+	FileStore * f = MassStorage::OpenFile(fullName.c_str(), OpenMode::read, 0);
+	if (f == nullptr)
+	{
+		reply.printf("Height map file %s not found", fullName.c_str());
+		return GCodeResult::error;
+	}
+
+	HeightMap * const tempMap = new HeightMap;
+	reply.printf("Failed to load height map from file %s: ", fullName.c_str());	// set up error message to append to
+	bool err = tempMap->LoadFromFile(f, fullName.c_str(), reply);
+	f->Close();
+	if (!err)
+	{
+		reply.Clear();															// get rid of the error message
+		err = TrySaveHeightMap(destFileName.c_str(), reply, tempMap);
+	}
+	delete tempMap;
+	return GetGCodeResultFromError(err);
+}
+
 #endif
 
 // Stop using bed compensation
@@ -325,6 +325,14 @@ bool GCodes::HandleGcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 #endif
 					break;
 
+				case 4:		// convert height map file between CSV and binary formats
+#if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
+					result = ConvertHeightMap(gb, reply);
+#else
+					result = GCodeResult::errorNotSupported;
+#endif
+					break;
+
 				default:
 					result = GCodeResult::badOrMissingParameter;
 					break;
@@ -1179,7 +1187,10 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 					if (seen)
 					{
 						const bool updateFile = !gb.Seen('F') || gb.GetUIValue() == 1;
-						result = SimulateFile(gb, reply, simFileName.GetRef(), updateFile);
+						uint32_t fileSimulationMode = (uint32_t)SimulationMode::normal;
+						bool dummy;
+						gb.TryGetLimitedUIValue('S', fileSimulationMode, dummy, (uint32_t)SimulationMode::normal + 1);
+						result = SimulateFile(gb, reply, simFileName.GetRef(), updateFile, (fileSimulationMode == (uint32_t)SimulationMode::debug) ? SimulationMode::debug : SimulationMode::normal);
 					}
 					else
 					{
@@ -3412,6 +3423,12 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 						reprap.GetMove().SetJerkPolicy(gb.GetUIValue());
 					}
 
+					if (gb.Seen('J'))
+					{
+						seenAxis = true;
+						reprap.GetMove().SetJunctionDeviation(max<float>(gb.GetFValue(), 0.0));
+					}
+
 					if (seenAxis)
 					{
 						reprap.MoveUpdated();
@@ -3434,6 +3451,11 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 						{
 							reply.catf(", jerk policy: %u", reprap.GetMove().GetJerkPolicy());
 						}
+						const float junctionDeviation = reprap.GetMove().GetJunctionDeviation();
+						if (junctionDeviation > 0.0)
+						{
+							reply.catf(", junction deviation: %.3fmm", (double)junctionDeviation);
+						}
 					}
 				}
 				break;
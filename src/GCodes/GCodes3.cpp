@@ -416,7 +416,8 @@ GCodeResult GCodes::DefineGrid(GCodeBuffer& gb, const StringRef &reply) THROWS(G
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE || HAS_EMBEDDED_FILES
 
 // Handle M37 to simulate a whole file
-GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile)
+// If simMode is 'debug' then step generation is simulated too, so that the movement planner timing statistics reported by M122 cover the whole file
+GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile, SimulationMode simMode)
 {
 	if (reprap.GetPrintMonitor().IsPrinting())
 	{
@@ -445,7 +446,7 @@ GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const
 # else
 		updateFileWhenSimulationComplete = updateFile;
 # endif
-		simulationMode = SimulationMode::normal;
+		simulationMode = simMode;
 		reprap.GetMove().Simulate(simulationMode);
 		reprap.GetPrintMonitor().StartingPrint(file.c_str());
 		StartPrinting(true);
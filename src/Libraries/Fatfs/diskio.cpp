@@ -51,6 +51,7 @@
 
 #include "RepRapFirmware.h"
 #include <Platform/RepRap.h>
+#include <Platform/Platform.h>
 #include <Platform/Tasks.h>
 #include <Movement/StepTimer.h>
 
@@ -60,6 +61,11 @@ static unsigned int highestSdRetriesDone = 0;
 static uint32_t longestWriteTime = 0;
 static uint32_t longestReadTime = 0;
 
+#if SUPPORT_SD_READ_CACHE
+static uint32_t sectorsReadFromCard = 0;
+static uint32_t cardReadTicks = 0;
+#endif
+
 unsigned int DiskioGetAndClearMaxRetryCount() noexcept
 {
 	const unsigned int ret = highestSdRetriesDone;
@@ -106,6 +112,204 @@ float DiskioGetAndClearLongestWriteTime() noexcept
 #define SECTOR_SIZE_2048 4
 #define SECTOR_SIZE_4096 8
 
+// Read sectors from the card, retrying if necessary
+static DRESULT ReadSectors(BYTE drv, BYTE *buff, DWORD sector, unsigned int count) noexcept
+{
+	unsigned int retryNumber = 0;
+	uint32_t retryDelay = SdCardRetryDelay;
+	for (;;)
+	{
+		uint32_t time = StepTimer::GetTimerTicks();
+		const Ctrl_status ret = memory_2_ram(drv, sector, buff, count);
+		time = StepTimer::GetTimerTicks() - time;
+		if (time > longestReadTime)
+		{
+			longestReadTime = time;
+		}
+
+		if (ret == CTRL_GOOD)
+		{
+#if SUPPORT_SD_READ_CACHE
+			sectorsReadFromCard += count;
+			cardReadTicks += time;
+#endif
+			break;
+		}
+
+		if (reprap.Debug(moduleStorage))
+		{
+			debugPrintf("SD read error %d\n", (int)ret);
+		}
+
+		++retryNumber;
+		if (retryNumber == MaxSdCardTries)
+		{
+			return RES_ERROR;
+		}
+		delay(retryDelay);
+		retryDelay *= 2;
+	}
+
+	if (retryNumber > highestSdRetriesDone)
+	{
+		highestSdRetriesDone = retryNumber;
+	}
+
+	return RES_OK;
+}
+
+#if SUPPORT_SD_READ_CACHE
+
+// Read-ahead cache. Because FatFs is configured with FF_FS_TINY, all files on a volume share a single sector buffer and FatFs reads most sectors
+// one at a time. When several files are being read at once (for example a job file, a macro and a file being downloaded) the card gets a stream
+// of single-sector reads. So we keep track of a few sequential read streams, and when a read continues one of them we read a whole cache line
+// of sectors in a single transfer. Writes go straight to the card and discard any cached copies of the sectors written.
+// The SAME5x has much less RAM than the SAME70, so it gets a smaller cache with shorter lines.
+# if SAME70
+constexpr size_t NumCacheLines = 4;
+constexpr size_t SectorsPerCacheLine = 16;			// 8Kb per line
+# else
+constexpr size_t NumCacheLines = 2;
+constexpr size_t SectorsPerCacheLine = 4;			// 2Kb per line
+# endif
+constexpr size_t NumReadStreams = 6;
+
+struct CacheLine
+{
+	bool Contains(BYTE pDrv, DWORD sector, unsigned int count) const noexcept
+	{
+		return numSectors != 0 && drv == pDrv && sector >= firstSector && sector + count <= firstSector + numSectors;
+	}
+
+	bool Overlaps(BYTE pDrv, DWORD sector, unsigned int count) const noexcept
+	{
+		return numSectors != 0 && drv == pDrv && sector < firstSector + numSectors && sector + count > firstSector;
+	}
+
+	BYTE *data;										// points into cacheLineData
+	DWORD firstSector;
+	uint32_t lastUsed;
+	uint8_t numSectors;								// zero if the line is free
+	BYTE drv;
+};
+
+struct ReadStream
+{
+	DWORD nextSector;
+	uint32_t lastUsed;
+	BYTE drv;
+	bool inUse;
+};
+
+// The card interface reads the data using DMA, so on the SAME70 the line data must not be in cached memory
+alignas(4) static __nocache BYTE cacheLineData[NumCacheLines][SectorsPerCacheLine * SECTOR_SIZE_DEFAULT];
+static CacheLine cacheLines[NumCacheLines];
+static ReadStream readStreams[NumReadStreams];
+static Mutex cacheMutex;
+static uint32_t cacheUseCounter = 0;
+static uint32_t cacheHits = 0, cacheMisses = 0, linesReadAhead = 0;
+
+void DiskioInit() noexcept
+{
+	cacheMutex.Create("SdCache");
+	for (size_t i = 0; i < NumCacheLines; ++i)
+	{
+		cacheLines[i].data = cacheLineData[i];
+	}
+}
+
+// Discard any cached sectors of a drive in the specified range
+static void InvalidateCache(BYTE drv, DWORD sector, unsigned int count) noexcept
+{
+	MutexLocker lock(cacheMutex);
+	for (CacheLine& line : cacheLines)
+	{
+		if (line.Overlaps(drv, sector, count))
+		{
+			line.numSectors = 0;
+		}
+	}
+}
+
+// Record a read in the stream table. Return true if it continues a stream that we were already tracking.
+static bool UpdateReadStreams(BYTE drv, DWORD sector, unsigned int count) noexcept
+{
+	ReadStream *lruStream = &readStreams[0];
+	for (ReadStream& rs : readStreams)
+	{
+		if (rs.inUse && rs.drv == drv && rs.nextSector == sector)
+		{
+			rs.nextSector = sector + count;
+			rs.lastUsed = cacheUseCounter;
+			return true;
+		}
+		if (!rs.inUse || (lruStream->inUse && (int32_t)(rs.lastUsed - lruStream->lastUsed) < 0))
+		{
+			lruStream = &rs;
+		}
+	}
+
+	lruStream->drv = drv;
+	lruStream->nextSector = sector + count;
+	lruStream->lastUsed = cacheUseCounter;
+	lruStream->inUse = true;
+	return false;
+}
+
+// Read sectors of a drive with 512-byte sectors, using the cache if possible
+static DRESULT CachedRead(BYTE drv, BYTE *buff, DWORD sector, unsigned int count, uint32_t lastSector) noexcept
+{
+	MutexLocker lock(cacheMutex);
+	++cacheUseCounter;
+	const bool sequential = UpdateReadStreams(drv, sector, count);
+
+	CacheLine *lruLine = &cacheLines[0];
+	for (CacheLine& line : cacheLines)
+	{
+		if (line.Contains(drv, sector, count))
+		{
+			++cacheHits;
+			line.lastUsed = cacheUseCounter;
+			memcpy(buff, line.data + (sector - line.firstSector) * SECTOR_SIZE_DEFAULT, count * SECTOR_SIZE_DEFAULT);
+			return RES_OK;
+		}
+		if (line.numSectors == 0 || (lruLine->numSectors != 0 && (int32_t)(line.lastUsed - lruLine->lastUsed) < 0))
+		{
+			lruLine = &line;
+		}
+	}
+
+	++cacheMisses;
+	if (sequential && count < SectorsPerCacheLine)
+	{
+		// This read continues a sequential stream, so read ahead a whole line
+		const unsigned int numSectors = min<uint32_t>(SectorsPerCacheLine, lastSector + 1 - sector);
+		lruLine->numSectors = 0;
+		if (ReadSectors(drv, lruLine->data, sector, numSectors) == RES_OK)
+		{
+			++linesReadAhead;
+			lruLine->drv = drv;
+			lruLine->firstSector = sector;
+			lruLine->numSectors = numSectors;
+			lruLine->lastUsed = cacheUseCounter;
+			memcpy(buff, lruLine->data, count * SECTOR_SIZE_DEFAULT);
+			return RES_OK;
+		}
+	}
+	return ReadSectors(drv, buff, sector, count);
+}
+
+void DiskioCacheDiagnostics(MessageType mtype) noexcept
+{
+	const uint32_t numReads = cacheHits + cacheMisses;
+	reprap.GetPlatform().MessageF(mtype, "SD read cache: %" PRIu32 " reads, hit rate %.1f%%, %" PRIu32 " lines read ahead, card read %.2fMbytes/sec\n",
+									numReads, (double)((numReads == 0) ? 0.0 : (float)cacheHits * 100.0/(float)numReads), linesReadAhead,
+									(double)((float)sectorsReadFromCard * SECTOR_SIZE_DEFAULT * (float)StepClockRate * 0.000001/(float)max<uint32_t>(cardReadTicks, 1)));
+	cacheHits = cacheMisses = linesReadAhead = sectorsReadFromCard = cardReadTicks = 0;
+}
+
+#endif
+
 /**
  * \brief Initialize a disk.
  *
@@ -139,6 +343,10 @@ DSTATUS disk_initialize(BYTE drv) noexcept
 		return STA_PROTECT;
 	}
 
+#if SUPPORT_SD_READ_CACHE
+	InvalidateCache(drv, 0, 0xFFFFFFFF);		// the card may have been changed
+#endif
+
 	/* The memory should already be initialized */
 	return 0;
 }
@@ -194,44 +402,14 @@ DRESULT disk_read(BYTE drv, BYTE *buff, DWORD sector, BYTE count) noexcept
 		return RES_PARERR;
 	}
 
-	/* Read the data */
-	unsigned int retryNumber = 0;
-	uint32_t retryDelay = SdCardRetryDelay;
-	for (;;)
-	{
-		uint32_t time = StepTimer::GetTimerTicks();
-		const Ctrl_status ret = memory_2_ram(drv, sector, buff, count);
-		time = StepTimer::GetTimerTicks() - time;
-		if (time > longestReadTime)
-		{
-			longestReadTime = time;
-		}
-
-		if (ret == CTRL_GOOD)
-		{
-			break;
-		}
-
-		if (reprap.Debug(moduleStorage))
-		{
-			debugPrintf("SD read error %d\n", (int)ret);
-		}
-
-		++retryNumber;
-		if (retryNumber == MaxSdCardTries)
-		{
-			return RES_ERROR;
-		}
-		delay(retryDelay);
-		retryDelay *= 2;
-	}
-
-	if (retryNumber > highestSdRetriesDone)
+#if SUPPORT_SD_READ_CACHE
+	if (uc_sector_size == SECTOR_SIZE_512)
 	{
-		highestSdRetriesDone = retryNumber;
+		return CachedRead(drv, buff, sector, count, ul_last_sector_num);
 	}
+#endif
 
-	return RES_OK;
+	return ReadSectors(drv, buff, sector, count);
 }
 
 /**
@@ -272,8 +450,11 @@ DRESULT disk_write(BYTE drv, BYTE const *buff, DWORD sector, BYTE count) noexcep
 		return RES_PARERR;
 	}
 
-	// Write the data
+#if SUPPORT_SD_READ_CACHE
+	InvalidateCache(drv, sector, count);
+#endif
 
+	// Write the data
 	unsigned int retryNumber = 0;
 	uint32_t retryDelay = SdCardRetryDelay;
 	for (;;)
@@ -6,10 +6,21 @@
 
 #ifdef __cplusplus
 
+#if SAME70 || SAME5x
+# define SUPPORT_SD_READ_CACHE	(1)		// read ahead sequentially-read sectors in multi-sector transfers and cache them
+#else
+# define SUPPORT_SD_READ_CACHE	(0)
+#endif
+
 unsigned int DiskioGetAndClearMaxRetryCount() noexcept;
 float DiskioGetAndClearLongestReadTime() noexcept;
 float DiskioGetAndClearLongestWriteTime() noexcept;
 
+#if SUPPORT_SD_READ_CACHE
+void DiskioInit() noexcept;
+void DiskioCacheDiagnostics(MessageType mtype) noexcept;
+#endif
+
 extern "C" {
 
 #endif
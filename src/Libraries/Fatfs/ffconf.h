@@ -34,7 +34,11 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_FASTSEEK	0
+#if SAME70 || SAME5x	// dc: only these processors have enough RAM for the cluster link maps that FileStore provides
+# define FF_USE_FASTSEEK	1
+#else
+# define FF_USE_FASTSEEK	0
+#endif
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
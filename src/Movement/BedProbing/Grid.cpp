@@ -10,7 +10,9 @@
 #include <Platform/RepRap.h>
 #include <GCodes/GCodes.h>
 #include <Storage/FileStore.h>
+#include <Storage/CRC32.h>
 #include <Math/Deviation.h>
+#include <Movement/StepTimer.h>
 
 #include <cmath>
 
@@ -327,7 +329,14 @@ void GridDefinition::PrintError(float originalAxis0range, float originalAxis1ran
 // Adding more fields to the header row can be handled in GridDefinition::ReadParameters(), though.
 const char * const HeightMap::HeightMapComment = "RepRapFirmware height map file v2";
 
-HeightMap::HeightMap() noexcept : useMap(false) { }
+HeightMap::HeightMap() noexcept
+	:
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	  cellCoefficientsValid(false),
+#endif
+	  useMap(false)
+{
+}
 
 void HeightMap::SetGrid(const GridDefinition& gd) noexcept
 {
@@ -339,6 +348,9 @@ void HeightMap::SetGrid(const GridDefinition& gd) noexcept
 void HeightMap::ClearGridHeights() noexcept
 {
 	gridHeightSet.ClearAll();
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	cellCoefficientsValid = false;
+#endif
 #if HAS_MASS_STORAGE
 	fileName.Clear();
 #endif
@@ -356,6 +368,9 @@ void HeightMap::SetGridHeight(size_t index, float height) noexcept
 	{
 		gridHeights[index] = height;
 		gridHeightSet.SetBit(index);
+#if HEIGHTMAP_CELL_COEFFICIENTS
+		cellCoefficientsValid = false;
+#endif
 	}
 }
 
@@ -374,9 +389,44 @@ unsigned int HeightMap::GetMinimumSegments(float deltaAxis0, float deltaAxis1) c
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 
+// Header of a binary height map file. All values are little-endian.
+// It is followed by the height of each grid point in microns as an int16_t, one row at a time.
+struct BinaryHeightMapHeader
+{
+	uint32_t magic;									// HeightMap::BinaryHeightMapMagic
+	uint16_t version;								// HeightMap::BinaryHeightMapVersion
+	uint16_t headerSize;							// the size of this header
+	uint16_t numPoints[2];							// the number of grid points along each axis
+	char axisLetters[2];
+	uint16_t reserved;
+	float mins[2];
+	float maxs[2];
+	float radius;
+	float spacings[2];
+	uint32_t crc;									// CRC32 of the header up to this field followed by the height data
+};
+
+static_assert(sizeof(BinaryHeightMapHeader) == 48);
+
+// Return true if we save height maps with this file name in binary format
+/*static*/ bool HeightMap::IsBinaryFileName(const char *fname) noexcept
+{
+	return StringEndsWithIgnoreCase(fname, BinaryHeightMapExtension);
+}
+
 // Save the grid to file returning true if an error occurred
 bool HeightMap::SaveToFile(FileStore *f, const char *fname, float zOffset) noexcept
 {
+	if (IsBinaryFileName(fname))
+	{
+		if (SaveToBinaryFile(f, zOffset))
+		{
+			return true;
+		}
+		fileName.copy(fname);
+		return false;
+	}
+
 	String<StringLength500> bufferSpace;
 	const StringRef buf = bufferSpace.GetRef();
 
@@ -438,7 +488,136 @@ bool HeightMap::SaveToFile(FileStore *f, const char *fname, float zOffset) noexc
 	return false;
 }
 
-// Load the grid from file, returning true if an error occurred with the error reason appended to the buffer
+// Return the height of a grid point in microns for saving in a binary file
+int16_t HeightMap::GetBinaryHeight(size_t index, float zOffset) const noexcept
+{
+	if (!gridHeightSet.IsBitSet(index))
+	{
+		return BinaryUnprobedHeight;
+	}
+	const int32_t microns = lrintf((gridHeights[index] + zOffset) * 1000.0);
+	return (int16_t)constrain<int32_t>(microns, BinaryUnprobedHeight + 1, INT16_MAX);
+}
+
+// Save the grid to file in binary format returning true if an error occurred
+bool HeightMap::SaveToBinaryFile(FileStore *f, float zOffset) const noexcept
+{
+	BinaryHeightMapHeader header;
+	header.magic = BinaryHeightMapMagic;
+	header.version = BinaryHeightMapVersion;
+	header.headerSize = sizeof(BinaryHeightMapHeader);
+	header.reserved = 0;
+	for (size_t axis = 0; axis < 2; ++axis)
+	{
+		header.numPoints[axis] = (uint16_t)def.nums[axis];
+		header.axisLetters[axis] = def.letters[axis];
+		header.mins[axis] = def.mins[axis];
+		header.maxs[axis] = def.maxs[axis];
+		header.spacings[axis] = def.spacings[axis];
+	}
+	header.radius = def.radius;
+
+	// The CRC goes in the header, so calculate it before writing anything
+	CRC32 crc;
+	crc.Update(reinterpret_cast<const char *>(&header), offsetof(BinaryHeightMapHeader, crc));
+	const size_t numPoints = def.NumPoints();
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		const int16_t height = GetBinaryHeight(i, zOffset);
+		crc.Update(reinterpret_cast<const char *>(&height), sizeof(height));
+	}
+	header.crc = crc.Get();
+
+	if (!f->Write(reinterpret_cast<const char *>(&header), sizeof(header)))
+	{
+		return true;
+	}
+
+	// Write the heights in chunks to limit the stack usage
+	int16_t buffer[64];
+	size_t index = 0;
+	while (index < numPoints)
+	{
+		const size_t numToWrite = min<size_t>(numPoints - index, ARRAY_SIZE(buffer));
+		for (size_t i = 0; i < numToWrite; ++i)
+		{
+			buffer[i] = GetBinaryHeight(index + i, zOffset);
+		}
+		if (!f->Write(reinterpret_cast<const char *>(buffer), numToWrite * sizeof(int16_t)))
+		{
+			return true;
+		}
+		index += numToWrite;
+	}
+	return false;
+}
+
+// Load the grid from a binary file, returning true if an error occurred with the error reason appended to the buffer
+bool HeightMap::LoadFromBinaryFile(FileStore *f, const StringRef& r) noexcept
+{
+	BinaryHeightMapHeader header;
+	if (f->Read(reinterpret_cast<char *>(&header), sizeof(header)) != (int)sizeof(header))
+	{
+		r.cat("failed to read header from file");
+		return true;
+	}
+
+	if (header.magic != BinaryHeightMapMagic || header.version != BinaryHeightMapVersion || header.headerSize != sizeof(BinaryHeightMapHeader))
+	{
+		r.cat("bad header or wrong version of binary height map");
+		return true;
+	}
+
+	GridDefinition newGrid;
+	const float axis0Range[2] = { header.mins[0], header.maxs[0] };
+	const float axis1Range[2] = { header.mins[1], header.maxs[1] };
+	if (!newGrid.Set(header.axisLetters, axis0Range, axis1Range, header.radius, header.spacings)
+		|| newGrid.nums[0] != header.numPoints[0] || newGrid.nums[1] != header.numPoints[1])
+	{
+		r.cat("invalid grid");
+		return true;
+	}
+
+	SetGrid(newGrid);
+
+	// Read all the heights in a single block into the start of the gridHeights array, which is large enough to hold them because a float is bigger than an int16_t.
+	// Then convert them to floats working backwards, so that we never overwrite a height that we haven't converted yet.
+	const size_t numPoints = def.NumPoints();
+	const size_t dataLength = numPoints * sizeof(int16_t);
+	int16_t *const rawHeights = reinterpret_cast<int16_t *>(gridHeights);
+	if (f->Read(reinterpret_cast<char *>(rawHeights), dataLength) != (int)dataLength)
+	{
+		r.cat("failed to read heights from file");
+		return true;
+	}
+
+	CRC32 crc;
+	crc.Update(reinterpret_cast<const char *>(&header), offsetof(BinaryHeightMapHeader, crc));
+	crc.Update(reinterpret_cast<const char *>(rawHeights), dataLength);
+	if (crc.Get() != header.crc)
+	{
+		r.cat("CRC mismatch");
+		return true;
+	}
+
+	for (size_t i = numPoints; i != 0; )
+	{
+		--i;
+		const int16_t height = rawHeights[i];
+		if (height == BinaryUnprobedHeight)
+		{
+			gridHeights[i] = 0.0;								// leave the point set as not valid
+		}
+		else
+		{
+			SetGridHeight(i, (float)height * 0.001);
+		}
+	}
+	return false;
+}
+
+// Load the grid from file, returning true if an error occurred with the error reason appended to the buffer.
+// The file may be in CSV or binary format.
 bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r) noexcept
 {
 	const size_t MaxLineLength = (MaxAxis0GridPoints * 8) + 2;					// maximum length of a line in the height map file, need 8 characters per grid point
@@ -450,7 +629,29 @@ bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r
 	GridDefinition newGrid;
 	int gridVersion;
 
-	if (f->ReadLine(buffer, sizeof(buffer)) <= 0)
+	// Check whether this is a binary height map
+	uint32_t magic;
+	if (f->Read(reinterpret_cast<char *>(&magic), sizeof(magic)) == (int)sizeof(magic) && magic == BinaryHeightMapMagic)
+	{
+		if (!f->Seek(0))
+		{
+			r.cat("failed to seek to start of file");
+			return true;
+		}
+		if (LoadFromBinaryFile(f, r))
+		{
+			return true;
+		}
+		ExtrapolateMissing();
+		fileName.copy(fname);
+		return false;
+	}
+
+	if (!f->Seek(0))
+	{
+		r.cat("failed to seek to start of file");
+	}
+	else if (f->ReadLine(buffer, sizeof(buffer)) <= 0)
 	{
 		r.cat(readFailureText);
 	}
@@ -562,6 +763,12 @@ unsigned int HeightMap::GetStatistics(Deviation& deviation, float& minError, flo
 bool HeightMap::UseHeightMap(bool b) noexcept
 {
 	useMap = b && def.IsValid();
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	if (useMap && !cellCoefficientsValid)
+	{
+		BuildCellCoefficients();
+	}
+#endif
 	return useMap;
 }
 
@@ -573,6 +780,22 @@ float HeightMap::GetInterpolatedHeightError(float axis0, float axis1) const noex
 		return 0.0;
 	}
 
+	uint32_t axis0Index, axis1Index;
+	float axis0Frac, axis1Frac;
+	GetCell(axis0, axis1, axis0Index, axis1Index, axis0Frac, axis1Frac);
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	if (cellCoefficientsValid)
+	{
+		const CellCoefficients& cell = cellCoefficients[(axis1Index * (def.nums[0] - 1)) + axis0Index];
+		return cell.z00 + (axis0Frac * cell.dzAxis0) + (axis1Frac * (cell.dzAxis1 + (axis0Frac * cell.dzAxis0Axis1)));
+	}
+#endif
+	return InterpolateAxis0Axis1(axis0Index, axis1Index, axis0Frac, axis1Frac);
+}
+
+// Find the grid cell that contains the specified point, clamping the point to the grid, and the fractional position of the point within the cell
+void HeightMap::GetCell(float axis0, float axis1, uint32_t& axis0Index, uint32_t& axis1Index, float& axis0Frac, float& axis1Frac) const noexcept
+{
 	// Last grid point
 	const float xLast = def.mins[0] + (def.nums[0]-1)*def.spacings[0];
 	const float yLast = def.mins[1] + (def.nums[1]-1)*def.spacings[1];
@@ -587,12 +810,83 @@ float HeightMap::GetInterpolatedHeightError(float axis0, float axis1) const noex
 
 	const float xf = (axis0 - def.mins[0]) * def.recipAxisSpacings[0];
 	const float xFloor = floor(xf);
-	const int32_t xIndex = (int32_t)xFloor;
+	axis0Index = (uint32_t)xFloor;
+	axis0Frac = xf - xFloor;
 	const float yf = (axis1 - def.mins[1]) * def.recipAxisSpacings[1];
 	const float yFloor = floor(yf);
-	const int32_t yIndex = (int32_t)yFloor;
+	axis1Index = (uint32_t)yFloor;
+	axis1Frac = yf - yFloor;
+}
+
+#if HEIGHTMAP_CELL_COEFFICIENTS
+
+// Calculate the bilinear interpolation coefficients of every grid cell, so that interpolating the height error needs just one cell lookup and three multiply-adds
+void HeightMap::BuildCellCoefficients() noexcept
+{
+	const uint32_t numCells0 = def.nums[0] - 1;
+	const uint32_t numCells1 = def.nums[1] - 1;
+	for (uint32_t iAxis1 = 0; iAxis1 < numCells1; ++iAxis1)
+	{
+		for (uint32_t iAxis0 = 0; iAxis0 < numCells0; ++iAxis0)
+		{
+			const uint32_t indexX0Y0 = GetMapIndex(iAxis0, iAxis1);
+			const float z00 = gridHeights[indexX0Y0];
+			const float z10 = gridHeights[indexX0Y0 + 1];
+			const float z01 = gridHeights[indexX0Y0 + def.nums[0]];
+			const float z11 = gridHeights[indexX0Y0 + def.nums[0] + 1];
+			CellCoefficients& cell = cellCoefficients[(iAxis1 * numCells0) + iAxis0];
+			cell.z00 = z00;
+			cell.dzAxis0 = z10 - z00;
+			cell.dzAxis1 = z01 - z00;
+			cell.dzAxis0Axis1 = (z11 - z10) - (z01 - z00);
+		}
+	}
+	cellCoefficientsValid = true;
+}
+
+#endif
 
-	return InterpolateAxis0Axis1(xIndex, yIndex, xf - xFloor, yf - yFloor);
+// Time the height error interpolation along a diagonal of the grid, with and without the precomputed cell coefficients
+void HeightMap::TimeInterpolation(const StringRef& reply) const noexcept
+{
+	if (!useMap)
+	{
+		reply.copy("Mesh bed compensation is not in use");
+		return;
+	}
+
+	constexpr unsigned int NumQueries = 1000;
+	const float axis0Step = (def.maxs[0] - def.mins[0])/(float)NumQueries;
+	const float axis1Step = (def.maxs[1] - def.mins[1])/(float)NumQueries;
+	float total = 0.0;
+
+	uint32_t startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumQueries; ++i)
+	{
+		uint32_t axis0Index, axis1Index;
+		float axis0Frac, axis1Frac;
+		GetCell(def.mins[0] + (float)i * axis0Step, def.mins[1] + (float)i * axis1Step, axis0Index, axis1Index, axis0Frac, axis1Frac);
+		total += InterpolateAxis0Axis1(axis0Index, axis1Index, axis0Frac, axis1Frac);
+	}
+	const uint32_t directTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumQueries; ++i)
+	{
+		total -= GetInterpolatedHeightError(def.mins[0] + (float)i * axis0Step, def.mins[1] + (float)i * axis1Step);
+	}
+	const uint32_t tableTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	reply.printf("Grid %" PRIu32 "x%" PRIu32 ": direct %.0f queries/sec, %s %.0f queries/sec, total difference %.2e",
+					def.nums[0], def.nums[1],
+					(double)((float)NumQueries * (float)StepClockRate/(float)max<uint32_t>(directTicks, 1)),
+#if HEIGHTMAP_CELL_COEFFICIENTS
+					(cellCoefficientsValid) ? "cell coefficients" : "direct",
+#else
+					"direct",
+#endif
+					(double)((float)NumQueries * (float)StepClockRate/(float)max<uint32_t>(tableTicks, 1)),
+					(double)total);
 }
 
 float HeightMap::InterpolateAxis0Axis1(uint32_t axis0Index, uint32_t axis1Index, float axis0Frac, float axis1Frac) const noexcept
@@ -670,6 +964,9 @@ void HeightMap::ExtrapolateMissing() noexcept
 	if (detZ <= 0)
 	{
 		// Not a valid plane (or a vertical one)
+#if HEIGHTMAP_CELL_COEFFICIENTS
+		BuildCellCoefficients();
+#endif
 		return;
 	}
 
@@ -698,6 +995,9 @@ void HeightMap::ExtrapolateMissing() noexcept
 			}
 		}
 	}
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	BuildCellCoefficients();
+#endif
 }
 
 // End
@@ -14,6 +14,12 @@
 class DataTransfer;
 class Deviation;
 
+#if SAME70 || SAME5x
+# define HEIGHTMAP_CELL_COEFFICIENTS	(1)					// 1 to precompute the bilinear interpolation coefficients of each grid cell
+#else
+# define HEIGHTMAP_CELL_COEFFICIENTS	(0)					// save RAM on the processors with less of it
+#endif
+
 // This class defines the bed probing grid
 class GridDefinition INHERIT_OBJECT_MODEL
 {
@@ -86,6 +92,7 @@ public:
 	bool LoadFromFile(FileStore *f, const char *fname, const StringRef& r) noexcept;	// Load the grid from file returning true if an error occurred
 
 	const char *GetFileName() const noexcept { return fileName.c_str(); }
+	static bool IsBinaryFileName(const char *fname) noexcept;							// Return true if we save height maps with this file name in binary format
 #endif
 
 	unsigned int GetMinimumSegments(float deltaAxis0, float deltaAxis1) const noexcept;	// Return the minimum number of segments for a move by this X or Y amount
@@ -96,20 +103,49 @@ public:
 	unsigned int GetStatistics(Deviation& deviation, float& minError, float& maxError) const noexcept;
 																	// Return number of points probed, mean and RMS deviation, min and max error
 	void ExtrapolateMissing() noexcept;								// Extrapolate missing points to ensure consistency
+	void TimeInterpolation(const StringRef& reply) const noexcept;	// Time the height error interpolation
 
 private:
 	static const char * const HeightMapComment;						// The start of the comment we write at the start of the height map file
+	static constexpr const char *BinaryHeightMapExtension = ".bin";	// The file name extension that selects the binary height map format when saving
+	static constexpr uint32_t BinaryHeightMapMagic = 0x50414D48;		// "HMAP" in little-endian byte order, at the start of a binary height map file
+	static constexpr uint16_t BinaryHeightMapVersion = 1;
+	static constexpr int16_t BinaryUnprobedHeight = INT16_MIN;		// The value we store in a binary height map file for points that were not probed
+
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	// Bilinear interpolation coefficients of a grid cell. The height error is z00 + axis0Frac * dzAxis0 + axis1Frac * (dzAxis1 + axis0Frac * dzAxis0Axis1).
+	struct CellCoefficients
+	{
+		float z00;
+		float dzAxis0;
+		float dzAxis1;
+		float dzAxis0Axis1;
+	};
+#endif
 
 	GridDefinition def;
 	float gridHeights[MaxGridProbePoints];							// The Z coordinates of the points on the bed that were probed
 	LargeBitmap<MaxGridProbePoints> gridHeightSet;					// Bitmap of which heights are set
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	String<MaxFilenameLength> fileName;								// The name of the file that this height map was loaded from or saved to
+#endif
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	CellCoefficients cellCoefficients[MaxGridProbePoints];			// The interpolation coefficients of each grid cell. There are fewer cells than grid points.
+	bool cellCoefficientsValid;										// True if cellCoefficients is up to date with gridHeights
 #endif
 	bool useMap;													// True to do bed compensation
 
 	uint32_t GetMapIndex(uint32_t axis0Index, uint32_t axis1Index) const noexcept { return (axis1Index * def.NumAxisPoints(0)) + axis0Index; }
 	void SetGridHeight(size_t index, float height) noexcept;							// Set the height of a grid point
+#if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
+	bool SaveToBinaryFile(FileStore *f, float zOffset) const noexcept;
+	bool LoadFromBinaryFile(FileStore *f, const StringRef& r) noexcept;
+	int16_t GetBinaryHeight(size_t index, float zOffset) const noexcept;
+#endif
+	void GetCell(float axis0, float axis1, uint32_t& axis0Index, uint32_t& axis1Index, float& axis0Frac, float& axis1Frac) const noexcept;
+#if HEIGHTMAP_CELL_COEFFICIENTS
+	void BuildCellCoefficients() noexcept;
+#endif
 
 	float InterpolateAxis0Axis1(uint32_t axis0Index, uint32_t axis1Index, float axis0Frac, float axis1Frac) const noexcept;
 };
@@ -539,6 +539,11 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 	// 7. Calculate the provisional accelerate and decelerate distances and the top speed
 	endSpeed = 0.0;							// until the next move asks us to adjust it
 
+	if (prev->state == provisional)
+	{
+		prev->CalcMaxEndSpeed();				// the direction of this move is now known, so we can work out the jerk-limited speed at the junction
+	}
+
 	if (prev->state == provisional && (move.GetJerkPolicy() != 0 || (flags.isPrintingMove == prev->flags.isPrintingMove && flags.xyMoving == prev->flags.xyMoving)))
 	{
 		// Try to meld this move to the previous move to avoid stop/start
@@ -911,11 +916,15 @@ bool DDA::IsAccelerationMove() const noexcept
 
 // Try to increase the ending speed of this move to allow the next move to start at targetNextSpeed.
 // Only called if this move and the next one are both printing moves.
+// Each move caches the jerk-limited speed at its junction with the next move, and we stop going back through the queue as soon as
+// the previous move already ends at the speed we would want, so only the suffix of the queue whose speeds can change gets replanned.
 /*static*/ void DDA::DoLookahead(DDARing& ring, DDA *laDDA) noexcept
 pre(state == provisional)
 {
 //	if (reprap.Debug(moduleDda)) debugPrintf("Adjusting, %f\n", laDDA->targetNextSpeed);
+	const uint32_t startClocks = StepTimer::GetTimerTicks();
 	unsigned int laDepth = 0;
+	unsigned int numReplanned = 0;
 	bool goingUp = true;
 
 	for(;;)					// this loop is used to nest lookahead without making recursive calls
@@ -939,6 +948,7 @@ pre(state == provisional)
 			{
 				const DDAState st = laDDA->prev->state;
 				// This is a deceleration-only move, and the previous one has a deceleration phase. We may have to adjust the previous move as well to get optimum behaviour.
+				bool adjustPrevious = false;
 				if (   st == provisional
 					&& (   reprap.GetMove().GetJerkPolicy() != 0
 						|| (   laDDA->prev->flags.xyMoving == laDDA->flags.xyMoving
@@ -951,10 +961,17 @@ pre(state == provisional)
 				{
 					laDDA->MatchSpeeds();
 					const float maxStartSpeed = fastSqrtf(fsquare(laDDA->beforePrepare.targetNextSpeed) + (2 * laDDA->deceleration * laDDA->totalDistance));
-					laDDA->prev->beforePrepare.targetNextSpeed = min<float>(maxStartSpeed, laDDA->requestedSpeed);
-					// leave 'goingUp' true
+					const float wantedStartSpeed = min<float>(min<float>(maxStartSpeed, laDDA->requestedSpeed), laDDA->prev->beforePrepare.maxEndSpeed);
+					if (wantedStartSpeed > laDDA->startSpeed)
+					{
+						// The previous move could end faster than it does now, so it is worth replanning it
+						laDDA->prev->beforePrepare.targetNextSpeed = wantedStartSpeed;
+						adjustPrevious = true;
+						// leave 'goingUp' true
+					}
 				}
-				else
+
+				if (!adjustPrevious)
 				{
 					// This move is a deceleration-only move but we can't adjust the previous one
 					if (st == frozen || st == executing)
@@ -1032,6 +1049,7 @@ pre(state == provisional)
 			}
 LA_DEBUG;
 			laDDA->RecalculateMove(ring);
+			++numReplanned;
 
 			if (laDepth == 0)
 			{
@@ -1041,6 +1059,7 @@ LA_DEBUG;
 					debugPrintf("Complete, %f\n", laDDA->targetNextSpeed);
 				}
 #endif
+				ring.RecordLookahead(numReplanned, StepTimer::GetTimerTicks() - startClocks);
 				return;
 			}
 
@@ -1080,6 +1099,14 @@ float DDA::AdvanceBabyStepping(DDARing& ring, size_t axis, float amount) noexcep
 			babySteppingToDo = constrain<float>(amount, -maxBabySteppingAmount, maxBabySteppingAmount);
 			cdda->directionVector[Z_AXIS] += babySteppingToDo/cdda->totalDistance;
 			cdda->totalDistance *= cdda->NormaliseLinearMotion(platform.GetLinearAxes());
+			if (cdda->prev->state == DDAState::provisional)
+			{
+				cdda->prev->CalcMaxEndSpeed();
+			}
+			if (cdda->next != this)
+			{
+				cdda->CalcMaxEndSpeed();
+			}
 			cdda->RecalculateMove(ring);
 			babySteppingDone += babySteppingToDo;
 			amount -= babySteppingToDo;
@@ -1206,19 +1233,81 @@ void DDA::RecalculateMove(DDARing& ring) noexcept
 // On return, targetNextSpeed is the actual speed we can achieve without exceeding the jerk limits.
 void DDA::MatchSpeeds() noexcept
 {
-	for (size_t drive = 0; drive < MaxAxesPlusExtruders; ++drive)
+	if (beforePrepare.targetNextSpeed > beforePrepare.maxEndSpeed)
+	{
+		beforePrepare.targetNextSpeed = beforePrepare.maxEndSpeed;
+	}
+}
+
+// Calculate the maximum speed at the junction between this move and the next one that doesn't exceed the jerk limits, and store it for MatchSpeeds to use.
+// If a junction deviation has been configured and both moves involve XY movement then the axis speeds are limited by the junction deviation model instead
+// of the per-axis jerk limits, which allows much higher speeds through the shallow corners of finely segmented curves. Extruders are always jerk limited.
+// This must be called whenever the direction vector of this move or the next one is set or changed.
+void DDA::CalcMaxEndSpeed() noexcept
+{
+	float maxSpeed = requestedSpeed;
+	size_t firstJerkLimitedDrive = 0;
+	const float junctionDeviation = reprap.GetMove().GetJunctionDeviation();
+	if (junctionDeviation > 0.0 && flags.xyMoving && next->flags.xyMoving)
+	{
+		const size_t numTotalAxes = reprap.GetGCodes().GetTotalAxes();
+		const float junctionSpeed = GetJunctionDeviationSpeed(junctionDeviation, numTotalAxes);
+		if (junctionSpeed < maxSpeed)
+		{
+			maxSpeed = junctionSpeed;
+		}
+		firstJerkLimitedDrive = numTotalAxes;
+	}
+
+	for (size_t drive = firstJerkLimitedDrive; drive < MaxAxesPlusExtruders; ++drive)
 	{
 		if (directionVector[drive] != 0.0 || next->directionVector[drive] != 0.0)
 		{
 			const float totalFraction = fabsf(directionVector[drive] - next->directionVector[drive]);
-			const float jerk = totalFraction * beforePrepare.targetNextSpeed;
 			const float allowedJerk = reprap.GetPlatform().GetInstantDv(drive);
-			if (jerk > allowedJerk)
+			if (totalFraction * maxSpeed > allowedJerk)
 			{
-				beforePrepare.targetNextSpeed = allowedJerk/totalFraction;
+				maxSpeed = allowedJerk/totalFraction;
 			}
 		}
 	}
+	beforePrepare.maxEndSpeed = maxSpeed;
+}
+
+// Return the maximum speed at the junction with the next move according to the junction deviation model.
+// The path is treated as following a circular arc that is tangent to both moves and whose closest approach to the junction point is the junction deviation.
+// The centripetal acceleration on that arc must not exceed the lower of the accelerations of the two moves.
+float DDA::GetJunctionDeviationSpeed(float junctionDeviation, size_t numAxes) const noexcept
+{
+	float dotProduct = 0.0, magSquared = 0.0, nextMagSquared = 0.0;
+	for (size_t axis = 0; axis < numAxes; ++axis)
+	{
+		dotProduct += directionVector[axis] * next->directionVector[axis];
+		magSquared += fsquare(directionVector[axis]);
+		nextMagSquared += fsquare(next->directionVector[axis]);
+	}
+
+	if (magSquared <= 0.0 || nextMagSquared <= 0.0)
+	{
+		return requestedSpeed;									// no axis movement in one of the moves, so leave it to the extruder jerk limits
+	}
+
+	// theta is the angle between the reversed direction of this move and the direction of the next one, so it is 180 degrees for straight-through movement
+	const float cosTheta = -dotProduct/fastSqrtf(magSquared * nextMagSquared);
+	if (cosTheta < -0.999999)
+	{
+		return requestedSpeed;									// the moves are collinear so there is no corner
+	}
+
+	const float minSpeed = reprap.GetPlatform().MinMovementSpeed();
+	if (cosTheta > 0.999999)
+	{
+		return minSpeed;										// the next move reverses this one
+	}
+
+	const float sinHalfTheta = fastSqrtf(0.5 * (1.0 - cosTheta));
+	const float radius = (junctionDeviation * sinHalfTheta)/(1.0 - sinHalfTheta);
+	return max<float>(fastSqrtf(min<float>(acceleration, next->acceleration) * radius), minSpeed);
 }
 
 // This is called by Move::CurrentMoveCompleted to update the live coordinates from the move that has just finished
@@ -2125,23 +2214,29 @@ void DDA::StepDrivers(Platform& p, uint32_t now) noexcept
 	}
 }
 
-// Simulate stepping the drivers, for debugging.
+// Simulate stepping the drivers, for debugging and for timing the step generation code.
 // This is basically a copy of DDA::SetDrivers except that instead of being called from the timer ISR and generating steps,
-// it is called from the Move task and outputs info on the step timings. It ignores endstops.
-void DDA::SimulateSteppingDrivers(Platform& p) noexcept
+// it is called from the Move task and optionally outputs info on the step timings. It ignores endstops.
+// Return the number of steps that would have been generated.
+unsigned int DDA::SimulateSteppingDrivers(Platform& p, bool printSteps) noexcept
 {
 	static uint32_t lastStepTime;
 	static bool checkTiming = false;
 
+	unsigned int numSteps = 0;
 	DriveMovement* dm = activeDMs;
 	if (dm != nullptr)
 	{
 		const uint32_t dueTime = dm->nextStepTime;
 		while (dm != nullptr && dueTime >= dm->nextStepTime)			// if the next step is due
 		{
-			const uint32_t timeDiff = dm->nextStepTime - lastStepTime;
-			const bool badTiming = checkTiming && (timeDiff < 10 || timeDiff > 100000000);
-			debugPrintf("%10" PRIu32 " D%u %c%s", dm->nextStepTime, dm->drive, (dm->direction) ? 'F' : 'B', (badTiming) ? " *\n" : "\n");
+			if (printSteps)
+			{
+				const uint32_t timeDiff = dm->nextStepTime - lastStepTime;
+				const bool badTiming = checkTiming && (timeDiff < 10 || timeDiff > 100000000);
+				debugPrintf("%10" PRIu32 " D%u %c%s", dm->nextStepTime, dm->drive, (dm->direction) ? 'F' : 'B', (badTiming) ? " *\n" : "\n");
+			}
+			++numSteps;
 			dm = dm->nextDM;
 		}
 		lastStepTime = dueTime;
@@ -2181,6 +2276,7 @@ void DDA::SimulateSteppingDrivers(Platform& p) noexcept
 		checkTiming = false;		// don't check the timing of the first step in the next move
 		state = completed;
 	}
+	return numSteps;
 }
 
 // Stop a drive and re-calculate the corresponding endpoint.
@@ -100,7 +100,7 @@ public:
 
 	void Start(Platform& p, uint32_t tim) noexcept SPEED_CRITICAL;					// Start executing the DDA, i.e. move the move.
 	void StepDrivers(Platform& p, uint32_t now) noexcept SPEED_CRITICAL;			// Take one step of the DDA, called by timer interrupt.
-	void SimulateSteppingDrivers(Platform& p) noexcept;								// For debugging use
+	unsigned int SimulateSteppingDrivers(Platform& p, bool printSteps) noexcept;	// For debugging and timing use, returns the number of steps generated
 	bool ScheduleNextStepInterrupt(StepTimer& timer) const noexcept SPEED_CRITICAL;	// Schedule the next interrupt, returning true if we can't because it is already due
 
 	void SetNext(DDA *n) noexcept { next = n; }
@@ -242,6 +242,8 @@ private:
 	DriveMovement *FindActiveDM(size_t drive) const noexcept;				// find the DM for a drive if there is one but only if it is active
 	void RecalculateMove(DDARing& ring) noexcept SPEED_CRITICAL;
 	void MatchSpeeds() noexcept SPEED_CRITICAL;
+	void CalcMaxEndSpeed() noexcept SPEED_CRITICAL;
+	float GetJunctionDeviationSpeed(float junctionDeviation, size_t numAxes) const noexcept SPEED_CRITICAL;
 	void StopDrive(size_t drive) noexcept;									// stop movement of a drive and recalculate the endpoint
 	void InsertDM(DriveMovement *dm) noexcept SPEED_CRITICAL;
 	void DeactivateDM(size_t drive) noexcept;
@@ -331,6 +333,7 @@ private:
 			float accelDistance;
 			float decelDistance;
 			float targetNextSpeed;					// The speed that the next move would like to start at, used to keep track of the lookahead without making recursive calls
+			float maxEndSpeed;						// The maximum speed at the junction with the next move allowed by the jerk limits, only valid once the next move has been added
 			float maxAcceleration;					// the maximum allowed acceleration for this move according to the limits set by M201
 		} beforePrepare;
 
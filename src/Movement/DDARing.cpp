@@ -32,9 +32,16 @@ constexpr ObjectModelTableEntry DDARing::objectModelTable[] =
 	// 0. DDARing members
 	{ "gracePeriod",			OBJECT_MODEL_FUNC(self->gracePeriod * MillisToSeconds, 3),			ObjectModelEntryFlags::none },
 	{ "length",					OBJECT_MODEL_FUNC((int32_t)self->numDdasInRing), 					ObjectModelEntryFlags::none },
+	{ "lookahead",				OBJECT_MODEL_FUNC(self, 1),											ObjectModelEntryFlags::live },
+
+	// 1. DDARing.lookahead members
+	{ "maxReplanned",			OBJECT_MODEL_FUNC((int32_t)self->maxMovesReplanned),				ObjectModelEntryFlags::live },
+	{ "passes",					OBJECT_MODEL_FUNC((int32_t)self->numLookaheadPasses),				ObjectModelEntryFlags::live },
+	{ "replanned",				OBJECT_MODEL_FUNC((int32_t)self->numMovesReplanned),				ObjectModelEntryFlags::live },
+	{ "time",					OBJECT_MODEL_FUNC((float)self->totalLookaheadClocks * (1.0f/(float)StepClockRate), 3),	ObjectModelEntryFlags::live },
 };
 
-constexpr uint8_t DDARing::objectModelTableDescriptor[] = { 1, 2 };
+constexpr uint8_t DDARing::objectModelTableDescriptor[] = { 2, 3, 4 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(DDARing)
 
@@ -70,6 +77,9 @@ void DDARing::Init2() noexcept
 {
 	stepErrors = 0;
 	numLookaheadUnderruns = numPrepareUnderruns = numNoMoveUnderruns = numLookaheadErrors = 0;
+	numLookaheadPasses = numMovesReplanned = maxMovesReplanned = reportedLookaheadPasses = reportedMovesReplanned = maxMovesReplannedSinceReport = 0;
+	totalLookaheadClocks = reportedLookaheadClocks = 0;
+	ResetTimingStatistics();
 	waitingForRingToEmpty = false;
 
 	// Put the origin on the lookahead ring with default velocity in the previous position to the first one that will be used.
@@ -261,6 +271,22 @@ bool DDARing::AddAsyncMove(const AsyncMove& nextMove) noexcept
 
 #endif
 
+// Record the work done by a lookahead pass
+void DDARing::RecordLookahead(unsigned int numReplanned, uint32_t clocksTaken) noexcept
+{
+	++numLookaheadPasses;
+	numMovesReplanned += numReplanned;
+	totalLookaheadClocks += clocksTaken;
+	if (numReplanned > maxMovesReplanned)
+	{
+		maxMovesReplanned = numReplanned;
+	}
+	if (numReplanned > maxMovesReplannedSinceReport)
+	{
+		maxMovesReplannedSinceReport = numReplanned;
+	}
+}
+
 // Try to process moves in the ring. Called by the Move task.
 // Return the maximum time in milliseconds that should elapse before we prepare further unprepared moves that are already in the ring, or TaskBase::TimeoutUnlimited if there are no unprepared moves left.
 uint32_t DDARing::Spin(SimulationMode simulationMode, bool waitingForSpace, bool shouldStartMove) noexcept
@@ -272,11 +298,19 @@ uint32_t DDARing::Spin(SimulationMode simulationMode, bool waitingForSpace, bool
 	if (simulationMode != SimulationMode::off && cdda != nullptr)
 	{
 		simulationTime += (float)cdda->GetClocksNeeded() * (1.0/StepClockRate);
-		if (simulationMode == SimulationMode::debug && reprap.Debug(moduleDda))
+		if (simulationMode == SimulationMode::debug)
 		{
+			// Generate the steps so that we can report the step generation time. Don't time them if we are printing them too.
+			const bool printSteps = reprap.Debug(moduleDda);
 			do
 			{
-				cdda->SimulateSteppingDrivers(reprap.GetPlatform());
+				const uint32_t startClocks = StepTimer::GetTimerTicks();
+				const unsigned int stepsDone = cdda->SimulateSteppingDrivers(reprap.GetPlatform(), printSteps);
+				if (!printSteps)
+				{
+					totalSimulatedStepClocks += StepTimer::GetTimerTicks() - startClocks;
+					numSimulatedSteps += stepsDone;
+				}
 			} while (cdda->GetState() != DDA::completed);
 		}
 		else
@@ -417,7 +451,18 @@ uint32_t DDARing::PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, u
 #endif
 		  )
 	{
+		const uint32_t startClocks = StepTimer::GetTimerTicks();
 		firstUnpreparedMove->Prepare(simulationMode);
+		const uint32_t clocksTaken = StepTimer::GetTimerTicks() - startClocks;
+		totalPrepareClocks += clocksTaken;
+		if (clocksTaken > maxPrepareClocks)
+		{
+			maxPrepareClocks = clocksTaken;
+		}
+		++numMovesPrepared;
+		totalDistancePrepared += firstUnpreparedMove->GetTotalDistance();
+		totalClocksPrepared += (float)firstUnpreparedMove->GetClocksNeeded();
+		totalRequestedClocksPrepared += firstUnpreparedMove->GetTotalDistance()/firstUnpreparedMove->GetRequestedSpeedMmPerClock();
 		moveTimeLeft += firstUnpreparedMove->GetTimeLeft();
 		++alreadyPrepared;
 		firstUnpreparedMove = firstUnpreparedMove->GetNext();
@@ -523,7 +568,15 @@ void DDARing::Interrupt(Platform& p) noexcept
 // DDARing timer callback function
 /*static*/ void DDARing::TimerCallback(CallbackParameter p) noexcept
 {
-	static_cast<DDARing*>(p.vp)->Interrupt(reprap.GetPlatform());
+	DDARing * const ring = static_cast<DDARing*>(p.vp);
+	const uint32_t isrStartClocks = StepTimer::GetTimerTicks();
+	ring->Interrupt(reprap.GetPlatform());
+	const uint32_t clocksTaken = StepTimer::GetTimerTicks() - isrStartClocks;
+	ring->totalStepInterruptClocks += clocksTaken;
+	if (clocksTaken > ring->maxStepInterruptClocks)
+	{
+		ring->maxStepInterruptClocks = clocksTaken;
+	}
 }
 
 // This is called when the state has been set to 'completed'. Step interrupts must be disabled or locked out when calling this.
@@ -963,6 +1016,48 @@ void DDARing::Diagnostics(MessageType mtype, const char *prefix) noexcept
 									prefix, scheduledMoves, completedMoves, numHiccups, stepErrors, numLookaheadErrors, numLookaheadUnderruns, numPrepareUnderruns, numNoMoveUnderruns,
 									(cdda == nullptr) ? -1 : (int)cdda->GetState());
 	numHiccups = stepErrors = numLookaheadUnderruns = numPrepareUnderruns = numNoMoveUnderruns = numLookaheadErrors = 0;
+
+	// Report the lookahead work since the last report. The totals are in the object model, so we don't reset them.
+	const uint32_t passes = numLookaheadPasses - reportedLookaheadPasses;
+	const uint32_t replanned = numMovesReplanned - reportedMovesReplanned;
+	const uint64_t clocks = totalLookaheadClocks - reportedLookaheadClocks;
+	reprap.GetPlatform().MessageF(mtype,
+									"Lookahead passes %" PRIu32 ", moves replanned avg %.2f max %" PRIu32 ", avg time %.1fus\n",
+									passes,
+									(double)((passes == 0) ? 0.0 : (float)replanned/(float)passes),
+									maxMovesReplannedSinceReport,
+									(double)((passes == 0) ? 0.0 : ((float)clocks * (1.0e6/(float)StepClockRate))/(float)passes));
+	reportedLookaheadPasses += passes;
+	reportedMovesReplanned += replanned;
+	reportedLookaheadClocks += clocks;
+	maxMovesReplannedSinceReport = 0;
+
+	// Report the move preparation and step generation times in nanoseconds
+	constexpr float NanosecondsPerStepClock = 1.0e9/(float)StepClockRate;
+	reprap.GetPlatform().MessageF(mtype,
+									"Prepared moves %" PRIu32 ", avg %.0fns max %.0fns, simulated steps %" PRIu32 ", avg %.0fns/step, max step ISR %.0fns\n",
+									numMovesPrepared,
+									(double)((numMovesPrepared == 0) ? 0.0 : ((float)totalPrepareClocks * NanosecondsPerStepClock)/(float)numMovesPrepared),
+									(double)((float)maxPrepareClocks * NanosecondsPerStepClock),
+									numSimulatedSteps,
+									(double)((numSimulatedSteps == 0) ? 0.0 : ((float)totalSimulatedStepClocks * NanosecondsPerStepClock)/(float)numSimulatedSteps),
+									(double)((float)maxStepInterruptClocks * NanosecondsPerStepClock));
+
+	// Report how close the planner came to the requested speeds, which shows the effect of the cornering limits
+	reprap.GetPlatform().MessageF(mtype,
+									"Average speed %.1fmm/sec, requested %.1fmm/sec\n",
+									(double)((totalClocksPrepared <= 0.0) ? 0.0 : (totalDistancePrepared * (float)StepClockRate)/totalClocksPrepared),
+									(double)((totalRequestedClocksPrepared <= 0.0) ? 0.0 : (totalDistancePrepared * (float)StepClockRate)/totalRequestedClocksPrepared));
+	ResetTimingStatistics();
+}
+
+// Reset the move preparation and step generation timing statistics
+void DDARing::ResetTimingStatistics() noexcept
+{
+	numMovesPrepared = totalPrepareClocks = maxPrepareClocks = 0;
+	totalDistancePrepared = totalClocksPrepared = totalRequestedClocksPrepared = 0.0;
+	numSimulatedSteps = totalSimulatedStepClocks = 0;
+	maxStepInterruptClocks = totalStepInterruptClocks = 0;
 }
 
 #if SUPPORT_LASER
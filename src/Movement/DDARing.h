@@ -80,7 +80,10 @@ public:
 #endif
 
 	void RecordLookaheadError() noexcept { ++numLookaheadErrors; }						// Record a lookahead error
+	void RecordLookahead(unsigned int numReplanned, uint32_t clocksTaken) noexcept;		// Record the work done by a lookahead pass
 	void Diagnostics(MessageType mtype, const char *prefix) noexcept;
+	void ResetTimingStatistics() noexcept;												// Reset the move preparation and step generation timing statistics
+	uint32_t GetStepInterruptClocks() const noexcept { return totalStepInterruptClocks; }	// Get the total time spent in the step ISR since the statistics were reset
 
 	bool SetWaitingToEmpty() noexcept;
 
@@ -124,8 +127,28 @@ private:
 	unsigned int numPrepareUnderruns;											// How many times we wanted a new move but there were only un-prepared moves in the queue
 	unsigned int numNoMoveUnderruns;											// How many times we wanted a new move but there were none
 	unsigned int numLookaheadErrors;											// How many times our lookahead algorithm failed
+	uint32_t numLookaheadPasses;												// How many lookahead passes we have done since startup
+	uint32_t numMovesReplanned;													// How many moves those passes replanned in total
+	uint32_t maxMovesReplanned;													// The largest number of moves replanned in a single pass
+	uint64_t totalLookaheadClocks;												// Total time spent in lookahead passes, in step clocks
+	uint32_t reportedLookaheadPasses;											// The totals when M122 last reported them, so that it can report the work done since then
+	uint32_t reportedMovesReplanned;											// without resetting the totals in the object model
+	uint64_t reportedLookaheadClocks;
+	uint32_t maxMovesReplannedSinceReport;										// The largest number of moves replanned in a single pass since M122 last reported
 	unsigned int stepErrors;													// count of step errors, for diagnostics
 
+	// Timing statistics for move preparation and step generation, all times in step clocks
+	uint32_t numMovesPrepared;													// how many moves we have prepared since the statistics were reset
+	uint32_t totalPrepareClocks;												// total time spent in DDA::Prepare
+	uint32_t maxPrepareClocks;													// longest time spent in DDA::Prepare
+	float totalDistancePrepared;												// total distance of the moves we have prepared
+	float totalClocksPrepared;													// total planned duration of those moves
+	float totalRequestedClocksPrepared;											// total duration of those moves had they run at the requested speeds throughout
+	uint32_t numSimulatedSteps;													// how many steps we generated in simulation mode
+	uint32_t totalSimulatedStepClocks;											// total time spent generating those steps
+	volatile uint32_t maxStepInterruptClocks;									// longest time spent in the step ISR, modified by the ISR
+	volatile uint32_t totalStepInterruptClocks;									// total time spent in the step ISR, modified by the ISR
+
 	float simulationTime;														// Print time since we started simulating
 	volatile int32_t movementAccumulators[MaxAxesPlusExtruders]; 				// Accumulated motor steps, used by filament monitors
 	volatile uint32_t extrudersPrintingSince;									// The milliseconds clock time when extrudersPrinting was set to true
@@ -28,6 +28,21 @@ static_assert(((int64_t)-10000000001 >> 1) == (int64_t)-5000000001);
 DriveMovement *DriveMovement::freeList = nullptr;
 unsigned int DriveMovement::numCreated = 0;
 
+#if DM_PRECOMPUTE_STEPS
+volatile uint32_t DriveMovement::numPrecomputedStepsUsed = 0;
+volatile uint32_t DriveMovement::numCalculatedSteps = 0;
+
+// Read and clear the step counters. They are incremented by the step ISR, so we must not be interrupted between reading and clearing them.
+/*static*/ void DriveMovement::GetAndResetStepCounters(uint32_t& precomputedSteps, uint32_t& calculatedSteps) noexcept
+{
+	const irqflags_t flags = IrqSave();
+	precomputedSteps = numPrecomputedStepsUsed;
+	calculatedSteps = numCalculatedSteps;
+	numPrecomputedStepsUsed = numCalculatedSteps = 0;
+	IrqRestore(flags);
+}
+#endif
+
 void DriveMovement::InitialAllocate(unsigned int num) noexcept
 {
 	while (num > numCreated)
@@ -53,6 +68,9 @@ DriveMovement *DriveMovement::Allocate(size_t p_drive, DMState st) noexcept
 	}
 	dm->drive = (uint8_t)p_drive;
 	dm->state = st;
+#if DM_PRECOMPUTE_STEPS
+	dm->numPrecomputedSteps = 0;
+#endif
 	return dm;
 }
 
@@ -438,7 +456,16 @@ bool DriveMovement::PrepareCartesianAxis(const DDA& dda, const PrepParams& param
 	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
 	stepsTillRecalc = 0;							// so that we don't skip the calculation
 	reverseStartStep = totalSteps + 1;				// no reverse phase
+#if DM_PRECOMPUTE_STEPS
+	if (!CalcNextStepTimeDirect(dda))
+	{
+		return false;
+	}
+	PrecomputeStepTimes(dda);
+	return true;
+#else
 	return CalcNextStepTime(dda);
+#endif
 }
 
 #if SUPPORT_LINEAR_DELTA
@@ -876,7 +903,16 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 	nextStepTime = 0;
 	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
 	stepsTillRecalc = 0;							// so that we don't skip the calculation
+#if DM_PRECOMPUTE_STEPS
+	if (!CalcNextStepTimeDirect(dda))
+	{
+		return false;
+	}
+	PrecomputeStepTimes(dda);
+	return true;
+#else
 	return CalcNextStepTime(dda);
+#endif
 }
 
 #if MS_USE_FPU
@@ -896,6 +932,275 @@ static inline uint32_t LimISqrt64(int64_t num) noexcept
 
 #endif
 
+// Return the time of a step in the current segment for a Cartesian or extruder motion state that is known at compile time.
+// The result is the time in step clocks since the start of the move, before conversion to integer when using floating point maths.
+template<DMState St> inline auto DriveMovement::StepTime(uint32_t stepNumber) const noexcept
+{
+	static_assert(St == DMState::cartLinear || St == DMState::cartAccel || St == DMState::cartDecelNoReverse || St == DMState::cartDecelForwardsReversing || St == DMState::cartDecelReverse);
+#if MS_USE_FPU
+	if constexpr (St == DMState::cartLinear)
+	{
+		return pB + (float)stepNumber * pC;
+	}
+	else if constexpr (St == DMState::cartAccel)
+	{
+		return pB + fastLimSqrtf(pA + pC * (float)stepNumber);
+	}
+	else if constexpr (St == DMState::cartDecelReverse)
+	{
+		// Convert the steps to int32_t because the net steps may be negative
+		return pB + fastLimSqrtf(pA + pC * (float)((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)stepNumber));
+	}
+	else
+	{
+		return pB - fastLimSqrtf(pA + pC * (float)stepNumber);
+	}
+#else
+	if constexpr (St == DMState::cartLinear)
+	{
+		return (uint32_t)(iB + stepNumber * iC);															//TODO ??scaling factor for iC ?
+	}
+	else if constexpr (St == DMState::cartAccel)
+	{
+		return (uint32_t)(iB + LimISqrt64(iA + iC * stepNumber));										//TODO ??scaling factor for iC ?
+	}
+	else if constexpr (St == DMState::cartDecelReverse)
+	{
+		return (uint32_t)(iB + LimISqrt64(iA + iC * ((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)stepNumber)));	//TODO ??scaling factor for iC ?
+	}
+	else
+	{
+		return (uint32_t)(iB - LimISqrt64(iA + iC * stepNumber));										//TODO ??scaling factor for iC ?
+	}
+#endif
+}
+
+// Calculate the times of a block of consecutive steps in the same phase of the current segment.
+// The step times don't depend on each other, so the compiler can unroll this loop and overlap the latency of each square root with the work for the following steps.
+// The Cortex-M7 has no floating point SIMD instructions and the DSP extension only provides 8- and 16-bit integer SIMD, which doesn't have enough precision for step times.
+template<DMState St> void DriveMovement::CalcStepTimes(uint32_t firstStep, unsigned int count, uint32_t *_ecv_array times) const noexcept
+{
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		times[i] = (uint32_t)StepTime<St>(firstStep + i);
+	}
+}
+
+// Calculate the times of a block of consecutive steps, dispatching on the motion state once for the whole block.
+// The caller must ensure that all the steps are in the current segment and that none of them is at or after the reversal point unless we are already reversing.
+// Return true if successful, false if the motion state isn't one that we can calculate in a block.
+bool DriveMovement::CalcStepTimeBlock(uint32_t firstStep, unsigned int count, uint32_t *_ecv_array times) const noexcept
+{
+	switch (state)
+	{
+	case DMState::cartLinear:
+		CalcStepTimes<DMState::cartLinear>(firstStep, count, times);
+		return true;
+
+	case DMState::cartAccel:
+		CalcStepTimes<DMState::cartAccel>(firstStep, count, times);
+		return true;
+
+	case DMState::cartDecelNoReverse:
+	case DMState::cartDecelForwardsReversing:
+		CalcStepTimes<DMState::cartDecelNoReverse>(firstStep, count, times);
+		return true;
+
+	case DMState::cartDecelReverse:
+		CalcStepTimes<DMState::cartDecelReverse>(firstStep, count, times);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// Calculate the time of a single step, dispatching on the motion state as the step ISR does. Used to time the step calculations.
+uint32_t DriveMovement::CalcStepTime(uint32_t stepNumber) const noexcept
+{
+	switch (state)
+	{
+	case DMState::cartLinear:
+		return (uint32_t)StepTime<DMState::cartLinear>(stepNumber);
+
+	case DMState::cartAccel:
+		return (uint32_t)StepTime<DMState::cartAccel>(stepNumber);
+
+	case DMState::cartDecelNoReverse:
+	case DMState::cartDecelForwardsReversing:
+		return (uint32_t)StepTime<DMState::cartDecelNoReverse>(stepNumber);
+
+	case DMState::cartDecelReverse:
+		return (uint32_t)StepTime<DMState::cartDecelReverse>(stepNumber);
+
+	default:
+		return 0;
+	}
+}
+
+// Time how long it takes to calculate step times one at a time and in blocks, and check both sets of results against the original step time formula.
+// Caution: this disables interrupts for up to a few hundred microseconds.
+/*static*/ void DriveMovement::TimeStepCalculations(const StringRef& reply) noexcept
+{
+	constexpr unsigned int BlockSize = 8;
+	constexpr unsigned int NumBlocks = 32;
+	constexpr unsigned int NumSteps = BlockSize * NumBlocks;
+
+	// Set up a Cartesian accelerating move with typical parameters, starting at 20000 clocks with a step interval of 50 clocks
+	DriveMovement dm(nullptr);
+	dm.state = DMState::cartAccel;
+	dm.totalSteps = dm.segmentStepLimit = dm.reverseStartStep = NumSteps + 1;
+#if MS_USE_FPU
+	dm.pA = 4.0e8;
+	dm.pB = 0.0;
+	dm.pC = 2.0e6;
+#else
+	dm.iA = 400000000;
+	dm.iB = 0;
+	dm.iC = 2000000;
+#endif
+
+	uint32_t times[BlockSize];
+	uint32_t scalarChecksum = 0;
+	unsigned int numMismatches = 0;
+
+	IrqDisable();
+	const uint32_t scalarStartTicks = StepTimer::GetTimerTicks();
+	for (uint32_t step = 1; step <= NumSteps; ++step)
+	{
+		scalarChecksum += dm.CalcStepTime(step);
+	}
+	const uint32_t scalarTicks = StepTimer::GetTimerTicks() - scalarStartTicks;
+
+	const uint32_t blockStartTicks = StepTimer::GetTimerTicks();
+	for (uint32_t step = 1; step <= NumSteps; step += BlockSize)
+	{
+		(void)dm.CalcStepTimeBlock(step, BlockSize, times);
+		scalarChecksum += times[0];				// so that the compiler can't optimise the block calculation away
+	}
+	const uint32_t blockTicks = StepTimer::GetTimerTicks() - blockStartTicks;
+	IrqEnable();
+
+	// Check the single and block results against the accelerating step time formula that the step ISR used before it was specialised on the motion state
+	for (uint32_t step = 1; step <= NumSteps; step += BlockSize)
+	{
+		(void)dm.CalcStepTimeBlock(step, BlockSize, times);
+		for (unsigned int i = 0; i < BlockSize; ++i)
+		{
+#if MS_USE_FPU
+			const uint32_t expected = (uint32_t)(dm.pB + fastLimSqrtf(dm.pA + dm.pC * (float)(step + i)));
+#else
+			const uint32_t expected = (uint32_t)(dm.iB + LimISqrt64(dm.iA + dm.iC * (step + i)));
+#endif
+			if (times[i] != expected || dm.CalcStepTime(step + i) != expected)
+			{
+				++numMismatches;
+			}
+		}
+	}
+
+	reply.printf("Step time calculations: single %.0f steps/sec, block of %u %.0f steps/sec, ",
+					(double)((float)NumSteps * (float)StepClockRate/(float)max<uint32_t>(scalarTicks, 1)),
+					BlockSize,
+					(double)((float)NumSteps * (float)StepClockRate/(float)max<uint32_t>(blockTicks, 1)));
+	if (numMismatches == 0)
+	{
+		reply.cat("results ok");
+	}
+	else
+	{
+		reply.catf("ERROR: %u of %u results differ from the reference calculation", numMismatches, NumSteps);
+	}
+}
+
+#if DM_PRECOMPUTE_STEPS
+
+// Calculate the times of the steps that follow the first one, so that the step ISR doesn't need to.
+// This is called by the Move task when it prepares a move, so it only ever calculates steps of a move that is not yet executing.
+// We stop at the end of the current segment, because changing segment can fail and we want any resulting step error to be detected in the ISR as usual.
+// We don't do this for segment-free delta moves, because their calculations can't be undone if they fail.
+void DriveMovement::PrecomputeStepTimes(const DDA &dda) noexcept
+{
+	const uint32_t firstStepTime = nextStepTime;
+	const bool firstStepDirection = direction;
+	uint8_t directions = 0;
+	unsigned int numSteps = 0;
+
+	// If we are single stepping then calculate as many steps as we can in one block. We stop before the last two steps of the move
+	// because they may need to be brought forwards, and before any reversal because the step ISR must change the motion state there.
+	if (stepsTillRecalc == 0)
+	{
+		uint32_t blockLimit = min<uint32_t>(segmentStepLimit, totalSteps - 1);
+		if (state == DMState::cartDecelForwardsReversing)
+		{
+			blockLimit = min<uint32_t>(blockLimit, reverseStartStep);
+		}
+
+		if (nextStep + 1 < blockLimit)
+		{
+			const unsigned int count = min<uint32_t>(MaxPrecomputedSteps, blockLimit - (nextStep + 1));
+			if (CalcStepTimeBlock(nextStep + 1, count, precomputedStepTimes))
+			{
+				// Any step that is late is an error, so leave the ISR to calculate it and report the error
+				while (numSteps < count && precomputedStepTimes[numSteps] <= dda.clocksNeeded)
+				{
+					++numSteps;
+				}
+
+				if (numSteps != 0)
+				{
+					const uint32_t lastStepTime = precomputedStepTimes[numSteps - 1];
+					const uint32_t previousStepTime = (numSteps >= 2) ? precomputedStepTimes[numSteps - 2] : nextStepTime;
+					stepInterval = (lastStepTime > previousStepTime) ? lastStepTime - previousStepTime : 0;
+					nextStepTime = lastStepTime;
+					nextStep += numSteps;
+					stepsTakenThisSegment = (stepsTakenThisSegment + numSteps >= 2) ? 2 : stepsTakenThisSegment + numSteps;
+					if (direction)
+					{
+						directions = (uint8_t)((1u << numSteps) - 1u);
+					}
+				}
+			}
+		}
+	}
+
+	while (numSteps < MaxPrecomputedSteps && nextStep < totalSteps && nextStep + 1 < segmentStepLimit)
+	{
+		const DMState oldState = state;
+		const uint32_t oldNextStep = nextStep;
+		const uint32_t oldNextStepTime = nextStepTime;
+		const uint32_t oldStepInterval = stepInterval;
+		const uint8_t oldStepsTillRecalc = stepsTillRecalc;
+		const uint8_t oldStepsTakenThisSegment = stepsTakenThisSegment;
+		if (!CalcNextStepTimeDirect(dda))
+		{
+			// Undo the failed calculation so that the ISR repeats it when it gets to this step
+			state = oldState;
+			nextStep = oldNextStep;
+			nextStepTime = oldNextStepTime;
+			stepInterval = oldStepInterval;
+			stepsTillRecalc = oldStepsTillRecalc;
+			stepsTakenThisSegment = oldStepsTakenThisSegment;
+			break;
+		}
+		precomputedStepTimes[numSteps] = nextStepTime;
+		if (direction)
+		{
+			directions |= 1u << numSteps;
+		}
+		++numSteps;
+	}
+
+	numPrecomputedSteps = numSteps;
+	precomputedStepIndex = 0;
+	precomputedDirections = directions;
+	nextStepTime = firstStepTime;
+	direction = firstStepDirection;
+	directionChanged = false;
+}
+
+#endif
+
 // Calculate and store the time since the start of the move when the next step for the specified DriveMovement is due.
 // We have already incremented nextStep and checked that it does not exceed totalSteps, so at least one more step is due
 // Return true if all OK, false to abort this move because the calculation has gone wrong
@@ -973,17 +1278,17 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 	{
 	case DMState::cartLinear:									// linear steady speed
 #if MS_USE_FPU
-		nextCalcStepTime = pB + (float)(nextStep + stepsTillRecalc) * pC;
+		nextCalcStepTime = StepTime<DMState::cartLinear>(nextStep + stepsTillRecalc);
 #else
-		iNextCalcStepTime = iB + (nextStep + stepsTillRecalc) * iC;	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = StepTime<DMState::cartLinear>(nextStep + stepsTillRecalc);
 #endif
 		break;
 
 	case DMState::cartAccel:									// Cartesian accelerating
 #if MS_USE_FPU
-		nextCalcStepTime = pB + fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
+		nextCalcStepTime = StepTime<DMState::cartAccel>(nextStep + stepsTillRecalc);
 #else
-		iNextCalcStepTime = iB + LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = StepTime<DMState::cartAccel>(nextStep + stepsTillRecalc);
 #endif
 		break;
 
@@ -991,9 +1296,9 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 		if (nextStep + stepsTillRecalc < reverseStartStep)
 		{
 #if MS_USE_FPU
-			nextCalcStepTime = pB - fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
+			nextCalcStepTime = StepTime<DMState::cartDecelForwardsReversing>(nextStep + stepsTillRecalc);
 #else
-			iNextCalcStepTime = iB - LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+			iNextCalcStepTime = StepTime<DMState::cartDecelForwardsReversing>(nextStep + stepsTillRecalc);
 #endif
 			break;
 		}
@@ -1002,19 +1307,19 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 		directionChanged = true;
 		state = DMState::cartDecelReverse;
 		// no break
-	case DMState::cartDecelReverse:								// Cartesian decelerating, reverse motion. Convert the steps to int32_t because the net steps may be negative.
+	case DMState::cartDecelReverse:								// Cartesian decelerating, reverse motion
 #if MS_USE_FPU
-		nextCalcStepTime = pB + fastLimSqrtf(pA + pC * (float)((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)(nextStep + stepsTillRecalc)));
+		nextCalcStepTime = StepTime<DMState::cartDecelReverse>(nextStep + stepsTillRecalc);
 #else
-		iNextCalcStepTime = iB + LimISqrt64(iA + iC * ((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)(nextStep + stepsTillRecalc)));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = StepTime<DMState::cartDecelReverse>(nextStep + stepsTillRecalc);
 #endif
 		break;
 
 	case DMState::cartDecelNoReverse:							// Cartesian accelerating with no reversal
 #if MS_USE_FPU
-		nextCalcStepTime = pB - fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
+		nextCalcStepTime = StepTime<DMState::cartDecelNoReverse>(nextStep + stepsTillRecalc);
 #else
-		iNextCalcStepTime = iB - LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = StepTime<DMState::cartDecelNoReverse>(nextStep + stepsTillRecalc);
 #endif
 		break;
 
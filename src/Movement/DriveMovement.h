@@ -18,6 +18,12 @@ class ExtruderShaper;
 
 #define EVEN_STEPS			(1)						// 1 to generate steps at even intervals when doing double/quad/octal stepping
 
+#if SAME70
+# define DM_PRECOMPUTE_STEPS	(1)						// 1 to calculate the first few step times of each Cartesian or extruder move in the Move task instead of in the step ISR
+#else
+# define DM_PRECOMPUTE_STEPS	(0)						// save RAM on the smaller processors
+#endif
+
 enum class DMState : uint8_t
 {
 	idle = 0,
@@ -49,6 +55,9 @@ public:
 	void operator delete(void* ptr, std::align_val_t align) noexcept {}
 
 	bool CalcNextStepTime(const DDA &dda) noexcept SPEED_CRITICAL;
+#if DM_PRECOMPUTE_STEPS
+	void PrecomputeStepTimes(const DDA &dda) noexcept;
+#endif
 	bool PrepareCartesianAxis(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
 #if SUPPORT_LINEAR_DELTA
 	bool PrepareDeltaAxis(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
@@ -68,8 +77,20 @@ public:
 	static DriveMovement *Allocate(size_t p_drive, DMState st) noexcept;
 	static void Release(DriveMovement *item) noexcept;
 
+	static void TimeStepCalculations(const StringRef& reply) noexcept;
+
+#if DM_PRECOMPUTE_STEPS
+	static void GetAndResetStepCounters(uint32_t& precomputedSteps, uint32_t& calculatedSteps) noexcept;
+#endif
+
 private:
+	bool CalcNextStepTimeDirect(const DDA &dda) noexcept SPEED_CRITICAL;
 	bool CalcNextStepTimeFull(const DDA &dda) noexcept SPEED_CRITICAL;
+	uint32_t GetStepNumber() const noexcept;			// get the number of the next step that the ISR will take
+	template<DMState St> auto StepTime(uint32_t stepNumber) const noexcept;
+	template<DMState St> void CalcStepTimes(uint32_t firstStep, unsigned int count, uint32_t *_ecv_array times) const noexcept;
+	bool CalcStepTimeBlock(uint32_t firstStep, unsigned int count, uint32_t *_ecv_array times) const noexcept SPEED_CRITICAL;
+	uint32_t CalcStepTime(uint32_t stepNumber) const noexcept;
 	bool NewCartesianSegment() noexcept SPEED_CRITICAL;
 	bool NewExtruderSegment() noexcept SPEED_CRITICAL;
 #if SUPPORT_LINEAR_DELTA
@@ -79,6 +100,14 @@ private:
 	static DriveMovement *freeList;
 	static unsigned int numCreated;
 
+#if DM_PRECOMPUTE_STEPS
+	static constexpr unsigned int MaxPrecomputedSteps = 8;
+	static_assert(MaxPrecomputedSteps <= 8);			// precomputedDirections has one bit per step
+
+	static volatile uint32_t numPrecomputedStepsUsed;	// how many steps the ISR took from the precomputed step times, for diagnostics
+	static volatile uint32_t numCalculatedSteps;		// how many steps the ISR had to calculate the step time for, for diagnostics
+#endif
+
 	// Parameters common to Cartesian, delta and extruder moves
 
 	DriveMovement *nextDM;								// link to next DM that needs a step
@@ -103,6 +132,14 @@ private:
 	uint32_t nextStepTime;								// how many clocks after the start of this move the next step is due
 	uint32_t stepInterval;								// how many clocks between steps
 
+#if DM_PRECOMPUTE_STEPS
+	// Step times that were calculated in advance by the Move task. When this is nonempty, nextStep is ahead of the step that the ISR will take next.
+	uint32_t precomputedStepTimes[MaxPrecomputedSteps];	// the step times that follow nextStepTime
+	uint8_t numPrecomputedSteps;						// how many entries in precomputedStepTimes have not been used yet
+	uint8_t precomputedStepIndex;						// index of the next entry in precomputedStepTimes to use
+	uint8_t precomputedDirections;						// bitmap of the direction for each entry in precomputedStepTimes
+#endif
+
 #if MS_USE_FPU
 	float distanceSoFar;
 	float timeSoFar;
@@ -154,11 +191,43 @@ private:
 	} mp;
 };
 
+// Calculate and store the time since the start of the move when the next step for the specified DriveMovement is due, using a precomputed step time if we have one.
+// Return true if there are more steps to do. When finished, leave nextStep == totalSteps + 1.
+inline bool DriveMovement::CalcNextStepTime(const DDA &dda) noexcept
+{
+#if DM_PRECOMPUTE_STEPS
+	if (numPrecomputedSteps != 0)
+	{
+		const unsigned int index = precomputedStepIndex++;
+		--numPrecomputedSteps;
+		++numPrecomputedStepsUsed;
+		nextStepTime = precomputedStepTimes[index];
+		const bool newDirection = (precomputedDirections >> index) & 1u;
+		if (newDirection != direction)
+		{
+			direction = newDirection;
+			directionChanged = true;
+		}
+# ifdef DUET3_MB6HC							// we need to increase the minimum step pulse length to be long enough for the TMC5160
+		asm volatile("nop");
+		asm volatile("nop");
+		asm volatile("nop");
+		asm volatile("nop");
+		asm volatile("nop");
+		asm volatile("nop");
+# endif
+		return true;
+	}
+	++numCalculatedSteps;
+#endif
+	return CalcNextStepTimeDirect(dda);
+}
+
 // Calculate and store the time since the start of the move when the next step for the specified DriveMovement is due.
 // Return true if there are more steps to do. When finished, leave nextStep == totalSteps + 1.
 // This is also used for extruders on delta machines.
 // We inline this part to speed things up when we are doing double/quad/octal stepping.
-inline bool DriveMovement::CalcNextStepTime(const DDA &dda) noexcept
+inline bool DriveMovement::CalcNextStepTimeDirect(const DDA &dda) noexcept
 {
 	++nextStep;
 	if (nextStep <= totalSteps)
@@ -194,23 +263,34 @@ inline bool DriveMovement::CalcNextStepTime(const DDA &dda) noexcept
 	return false;
 }
 
+// Get the number of the next step that the ISR will take, allowing for any step times that were calculated in advance
+inline uint32_t DriveMovement::GetStepNumber() const noexcept
+{
+#if DM_PRECOMPUTE_STEPS
+	return nextStep - numPrecomputedSteps;
+#else
+	return nextStep;
+#endif
+}
+
 // Return the number of net steps left for the move in the forwards direction.
 // We have already taken nextSteps - 1 steps, unless nextStep is zero.
 inline int32_t DriveMovement::GetNetStepsLeft() const noexcept
 {
+	const uint32_t stepNumber = GetStepNumber();
 	int32_t netStepsLeft;
 	if (reverseStartStep > totalSteps)		// if no reverse phase
 	{
-		netStepsLeft = (nextStep == 0) ? (int32_t)totalSteps : (int32_t)totalSteps - (int32_t)nextStep + 1;
+		netStepsLeft = (stepNumber == 0) ? (int32_t)totalSteps : (int32_t)totalSteps - (int32_t)stepNumber + 1;
 	}
-	else if (nextStep >= reverseStartStep)
+	else if (stepNumber >= reverseStartStep)
 	{
-		netStepsLeft = (int32_t)totalSteps - (int32_t)nextStep + 1;
+		netStepsLeft = (int32_t)totalSteps - (int32_t)stepNumber + 1;
 	}
 	else
 	{
 		const int32_t totalNetSteps = (int32_t)(2 * reverseStartStep) - (int32_t)totalSteps - 2;
-		netStepsLeft = (nextStep == 0) ? totalNetSteps : totalNetSteps - (int32_t)nextStep + 1;
+		netStepsLeft = (stepNumber == 0) ? totalNetSteps : totalNetSteps - (int32_t)stepNumber + 1;
 	}
 	return (direction) ? netStepsLeft : -netStepsLeft;
 }
@@ -219,14 +299,15 @@ inline int32_t DriveMovement::GetNetStepsLeft() const noexcept
 // We have already taken nextSteps - 1 steps, unless nextStep is zero.
 inline int32_t DriveMovement::GetNetStepsTaken() const noexcept
 {
+	const uint32_t stepNumber = GetStepNumber();
 	int32_t netStepsTaken;
-	if (nextStep < reverseStartStep || reverseStartStep > totalSteps)				// if no reverse phase, or not started it yet
+	if (stepNumber < reverseStartStep || reverseStartStep > totalSteps)				// if no reverse phase, or not started it yet
 	{
-		netStepsTaken = (nextStep == 0) ? 0 : (int32_t)nextStep - 1;
+		netStepsTaken = (stepNumber == 0) ? 0 : (int32_t)stepNumber - 1;
 	}
 	else
 	{
-		netStepsTaken = (int32_t)nextStep - (int32_t)(2 * reverseStartStep) + 1;	// allowing for direction having changed
+		netStepsTaken = (int32_t)stepNumber - (int32_t)(2 * reverseStartStep) + 1;	// allowing for direction having changed
 	}
 	return (direction) ? netStepsTaken : -netStepsTaken;
 }
@@ -243,7 +324,8 @@ inline void DriveMovement::Release(DriveMovement *item) noexcept
 // Get the current full step interval for this axis or extruder
 inline uint32_t DriveMovement::GetStepInterval(uint32_t microstepShift) const noexcept
 {
-	return (nextStep < totalSteps && nextStep > (1u << microstepShift))				// if at least 1 full step done
+	const uint32_t stepNumber = GetStepNumber();
+	return (stepNumber < totalSteps && stepNumber > (1u << microstepShift))			// if at least 1 full step done
 				? stepInterval << microstepShift									// return the interval between steps converted to full steps
 					: 0;
 }
@@ -40,6 +40,13 @@
 #include <Tools/Tool.h>
 #include <Endstops/ZProbe.h>
 #include <Platform/TaskPriorities.h>
+#include "Kinematics/CoreKinematics.h"
+#include "Kinematics/LinearDeltaKinematics.h"
+#include "Kinematics/ScaraKinematics.h"
+#include "Kinematics/HangprinterKinematics.h"
+#include "Kinematics/PolarKinematics.h"
+#include "Kinematics/RotaryDeltaKinematics.h"
+#include "Kinematics/FiveBarScaraKinematics.h"
 
 #if SUPPORT_IOBITS
 # include <Platform/PortControl.h>
@@ -102,6 +109,7 @@ constexpr ObjectModelTableEntry Move::objectModelTable[] =
 	{ "currentMove",			OBJECT_MODEL_FUNC(self, 2),																		ObjectModelEntryFlags::live },
 	{ "extruders",				OBJECT_MODEL_FUNC_NOSELF(&extrudersArrayDescriptor),											ObjectModelEntryFlags::live },
 	{ "idle",					OBJECT_MODEL_FUNC(self, 1),																		ObjectModelEntryFlags::none },
+	{ "junctionDeviation",		OBJECT_MODEL_FUNC(self->junctionDeviation, 3),													ObjectModelEntryFlags::none },
 	{ "kinematics",				OBJECT_MODEL_FUNC(self->kinematics),															ObjectModelEntryFlags::none },
 	{ "limitAxes",				OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().LimitAxes()),										ObjectModelEntryFlags::none },
 	{ "noMovesBeforeHoming",	OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().NoMovesBeforeHoming()),								ObjectModelEntryFlags::none },
@@ -175,7 +183,7 @@ constexpr ObjectModelTableEntry Move::objectModelTable[] =
 constexpr uint8_t Move::objectModelTableDescriptor[] =
 {
 	9 + SUPPORT_COORDINATE_ROTATION,
-	17 + SUPPORT_WORKPLACE_COORDINATES,
+	18 + SUPPORT_WORKPLACE_COORDINATES,
 	2,
 	4 + SUPPORT_LASER,
 	3,
@@ -203,11 +211,12 @@ Move::Move() noexcept
 	  heightController(nullptr),
 #endif
 	  maxPrintingAcceleration(ConvertAcceleration(DefaultPrintingAcceleration)), maxTravelAcceleration(ConvertAcceleration(DefaultTravelAcceleration)),
-	  jerkPolicy(0),
+	  jerkPolicy(0), junctionDeviation(0.0),
 	  numCalibratedFactors(0)
 {
 	// Kinematics must be set up here because GCodes::Init asks the kinematics for the assumed initial position
 	kinematics = Kinematics::Create(KinematicsType::cartesian);		// default to Cartesian
+	kinematicsType = KinematicsType::cartesian;
 	mainDDARing.Init1(InitialDdaRingLength);
 #if SUPPORT_ASYNC_MOVES
 	auxDDARing.Init1(AuxDdaRingLength);
@@ -433,6 +442,7 @@ bool Move::SetKinematics(KinematicsType k) noexcept
 		}
 		delete kinematics;
 		kinematics = nk;
+		kinematicsType = k;
 		reprap.MoveUpdated();
 	}
 	return true;
@@ -477,8 +487,10 @@ void Move::Diagnostics(MessageType mtype) noexcept
 	scratchString.copy(GetCompensationTypeString());
 
 	Platform& p = reprap.GetPlatform();
-	p.MessageF(mtype, "=== Move ===\nDMs created %u, segments created %u, maxWait %" PRIu32 "ms, bed compensation in use: %s, comp offset %.3f\n",
-						DriveMovement::NumCreated(), MoveSegment::NumCreated(), longestGcodeWaitInterval, scratchString.c_str(), (double)zShift);
+	p.MessageF(mtype, "=== Move ===\nDMs created %u, segments created %u, maxWait %" PRIu32 "ms, bed compensation in use: %s, comp offset %.3f\n"
+						"Kinematics %s, input shaping %s\n",
+						DriveMovement::NumCreated(), MoveSegment::NumCreated(), longestGcodeWaitInterval, scratchString.c_str(), (double)zShift,
+						kinematics->GetName(true), axisShaper.GetType().ToString());
 	longestGcodeWaitInterval = 0;
 
 #if 0	// debug only
@@ -514,6 +526,22 @@ void Move::Diagnostics(MessageType mtype) noexcept
 	maxDelay = maxDelayIncrease = 0;
 #endif
 
+#if DM_PRECOMPUTE_STEPS
+	// Report how many step times were calculated in advance, and the step rate we could sustain given the time spent in the step ISR
+	{
+		uint32_t precomputedSteps, calculatedSteps;
+		DriveMovement::GetAndResetStepCounters(precomputedSteps, calculatedSteps);
+# if SUPPORT_ASYNC_MOVES
+		const uint32_t isrClocks = mainDDARing.GetStepInterruptClocks() + auxDDARing.GetStepInterruptClocks();
+# else
+		const uint32_t isrClocks = mainDDARing.GetStepInterruptClocks();
+# endif
+		p.MessageF(mtype, "Step times precomputed %" PRIu32 ", calculated %" PRIu32 ", max sustainable step rate %.0f/sec\n",
+							precomputedSteps, calculatedSteps,
+							(double)((isrClocks == 0) ? 0.0 : ((float)(precomputedSteps + calculatedSteps) * (float)StepClockRate)/(float)isrClocks));
+	}
+#endif
+
 #if SUPPORT_ASYNC_MOVES
 	mainDDARing.Diagnostics(mtype, "Main");
 	auxDDARing.Diagnostics(mtype, "Aux");
@@ -539,11 +567,168 @@ int32_t Move::MotorMovementToSteps(size_t drive, float coord) noexcept
 	return lrintf(coord * reprap.GetPlatform().DriveStepsPerUnit(drive));
 }
 
+// Call the coordinate conversion functions of a kinematics class directly instead of through the vtable.
+// This lets the compiler inline the conversion for the most common kinematics types when link time optimisation is used.
+template<class K> static inline bool DirectCartesianToMotorSteps(const Kinematics *k, const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) noexcept
+{
+	return static_cast<const K *>(k)->K::CartesianToMotorSteps(machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+}
+
+template<class K> static inline void DirectMotorStepsToCartesian(const Kinematics *k, const int32_t motorPos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) noexcept
+{
+	static_cast<const K *>(k)->K::MotorStepsToCartesian(motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+}
+
+// Convert Cartesian coordinates to motor steps using the kinematics class that was selected when the kinematics was set
+bool Move::KinematicsCartesianToMotorSteps(const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const noexcept
+{
+	switch (kinematicsType)
+	{
+	case KinematicsType::cartesian:
+	case KinematicsType::coreXY:
+	case KinematicsType::coreXZ:
+	case KinematicsType::coreXYU:
+	case KinematicsType::coreXYUV:
+	case KinematicsType::markForged:
+		return DirectCartesianToMotorSteps<CoreKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+
+#if SUPPORT_LINEAR_DELTA
+	case KinematicsType::linearDelta:
+		return DirectCartesianToMotorSteps<LinearDeltaKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+#if SUPPORT_SCARA
+	case KinematicsType::scara:
+		return DirectCartesianToMotorSteps<ScaraKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+#if SUPPORT_HANGPRINTER
+	case KinematicsType::hangprinter:
+		return DirectCartesianToMotorSteps<HangprinterKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+#if SUPPORT_POLAR
+	case KinematicsType::polar:
+		return DirectCartesianToMotorSteps<PolarKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+#if SUPPORT_ROTARY_DELTA
+	case KinematicsType::rotaryDelta:
+		return DirectCartesianToMotorSteps<RotaryDeltaKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+#if SUPPORT_FIVEBARSCARA
+	case KinematicsType::fiveBarScara:
+		return DirectCartesianToMotorSteps<FiveBarScaraKinematics>(kinematics, machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+#endif
+
+	default:
+		return kinematics->CartesianToMotorSteps(machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, isCoordinated);
+	}
+}
+
+// Convert motor steps to Cartesian coordinates using the kinematics class that was selected when the kinematics was set
+void Move::KinematicsMotorStepsToCartesian(const int32_t motorPos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const noexcept
+{
+	switch (kinematicsType)
+	{
+	case KinematicsType::cartesian:
+	case KinematicsType::coreXY:
+	case KinematicsType::coreXZ:
+	case KinematicsType::coreXYU:
+	case KinematicsType::coreXYUV:
+	case KinematicsType::markForged:
+		DirectMotorStepsToCartesian<CoreKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+
+#if SUPPORT_LINEAR_DELTA
+	case KinematicsType::linearDelta:
+		DirectMotorStepsToCartesian<LinearDeltaKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+#if SUPPORT_SCARA
+	case KinematicsType::scara:
+		DirectMotorStepsToCartesian<ScaraKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+#if SUPPORT_HANGPRINTER
+	case KinematicsType::hangprinter:
+		DirectMotorStepsToCartesian<HangprinterKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+#if SUPPORT_POLAR
+	case KinematicsType::polar:
+		DirectMotorStepsToCartesian<PolarKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+#if SUPPORT_ROTARY_DELTA
+	case KinematicsType::rotaryDelta:
+		DirectMotorStepsToCartesian<RotaryDeltaKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+#if SUPPORT_FIVEBARSCARA
+	case KinematicsType::fiveBarScara:
+		DirectMotorStepsToCartesian<FiveBarScaraKinematics>(kinematics, motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+#endif
+
+	default:
+		kinematics->MotorStepsToCartesian(motorPos, stepsPerMm, numVisibleAxes, numTotalAxes, machinePos);
+		break;
+	}
+}
+
+// Time the coordinate conversions of the current kinematics, called through the vtable and directly
+void Move::TimeKinematics(const StringRef& reply) const noexcept
+{
+	constexpr unsigned int NumConversions = 100;
+	const float *_ecv_array const stepsPerMm = reprap.GetPlatform().GetDriveStepsPerUnit();
+	const size_t numVisibleAxes = reprap.GetGCodes().GetVisibleAxes();
+	const size_t numTotalAxes = reprap.GetGCodes().GetTotalAxes();
+
+	// Use a short line of positions close to the middle of the usual print area of all kinematics types
+	float machinePos[MaxAxes];
+	for (float& f : machinePos)
+	{
+		f = 0.0;
+	}
+	machinePos[Z_AXIS] = 10.0;
+	int32_t motorPos[MaxAxes];
+	bool ok = true;
+
+	uint32_t startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumConversions; ++i)
+	{
+		machinePos[X_AXIS] = (float)i * 0.1;
+		ok = kinematics->CartesianToMotorSteps(machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, true) && ok;
+	}
+	const uint32_t virtualTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	startTicks = StepTimer::GetTimerTicks();
+	for (unsigned int i = 0; i < NumConversions; ++i)
+	{
+		machinePos[X_AXIS] = (float)i * 0.1;
+		ok = KinematicsCartesianToMotorSteps(machinePos, stepsPerMm, numVisibleAxes, numTotalAxes, motorPos, true) && ok;
+	}
+	const uint32_t directTicks = StepTimer::GetTimerTicks() - startTicks;
+
+	reply.printf("Kinematics %s: virtual %.0f conversions/sec, direct %.0f conversions/sec%s",
+					kinematics->GetName(true),
+					(double)((float)NumConversions * (float)StepClockRate/(float)max<uint32_t>(virtualTicks, 1)),
+					(double)((float)NumConversions * (float)StepClockRate/(float)max<uint32_t>(directTicks, 1)),
+					(ok) ? "" : ", some positions were unreachable");
+}
+
 // Convert motor coordinates to machine coordinates. Used after homing and after individual motor moves.
 // This is computationally expensive on a delta or SCARA machine, so only call it when necessary, and never from the step ISR.
 void Move::MotorStepsToCartesian(const int32_t motorPos[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const noexcept
 {
-	kinematics->MotorStepsToCartesian(motorPos, reprap.GetPlatform().GetDriveStepsPerUnit(), numVisibleAxes, numTotalAxes, machinePos);
+	KinematicsMotorStepsToCartesian(motorPos, reprap.GetPlatform().GetDriveStepsPerUnit(), numVisibleAxes, numTotalAxes, machinePos);
 	if (reprap.Debug(moduleMove) && !inInterrupt())
 	{
 		debugPrintf("Forward transformed %" PRIi32 " %" PRIi32 " %" PRIi32 " to %.2f %.2f %.2f\n",
@@ -556,7 +741,7 @@ void Move::MotorStepsToCartesian(const int32_t motorPos[], size_t numVisibleAxes
 // This may be called from an ISR, e.g. via Kinematics::OnHomingSwitchTriggered, DDA::SetPositions and Move::EndPointToMachine
 bool Move::CartesianToMotorSteps(const float machinePos[MaxAxes], int32_t motorPos[MaxAxes], bool isCoordinated) const noexcept
 {
-	const bool b = kinematics->CartesianToMotorSteps(machinePos, reprap.GetPlatform().GetDriveStepsPerUnit(),
+	const bool b = KinematicsCartesianToMotorSteps(machinePos, reprap.GetPlatform().GetDriveStepsPerUnit(),
 														reprap.GetGCodes().GetVisibleAxes(), reprap.GetGCodes().GetTotalAxes(), motorPos, isCoordinated);
 	if (reprap.Debug(moduleMove) && !inInterrupt())
 	{
@@ -937,6 +1122,7 @@ void Move::Simulate(SimulationMode simMode) noexcept
 	if (simMode != SimulationMode::off)
 	{
 		mainDDARing.ResetSimulationTime();
+		mainDDARing.ResetTimingStatistics();
 	}
 }
 
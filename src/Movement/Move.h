@@ -118,6 +118,7 @@ public:
 																							// Convert motor coordinates to machine coordinates
 	void AdjustMotorPositions(const float adjustment[], size_t numMotors) noexcept;			// Perform motor endpoint adjustment
 	const char* GetGeometryString() const noexcept { return kinematics->GetName(true); }
+	void TimeKinematics(const StringRef& reply) const noexcept;								// Time the coordinate conversions of the current kinematics
 	bool IsAccessibleProbePoint(float axesCoords[MaxAxes], AxesBitmap axes) const noexcept;
 
 	// Temporary kinematics functions
@@ -173,6 +174,8 @@ public:
 
 	unsigned int GetJerkPolicy() const noexcept { return jerkPolicy; }
 	void SetJerkPolicy(unsigned int jp) noexcept { jerkPolicy = jp; }
+	float GetJunctionDeviation() const noexcept { return junctionDeviation; }
+	void SetJunctionDeviation(float jd) noexcept { junctionDeviation = jd; }
 
 #if HAS_SMART_DRIVERS
 	uint32_t GetStepInterval(size_t axis, uint32_t microstepShift) const noexcept;			// Get the current step interval for this axis or extruder
@@ -267,6 +270,7 @@ private:
 	float maxTravelAcceleration;
 
 	unsigned int jerkPolicy;							// When we allow jerk
+	float junctionDeviation;							// The junction deviation in mm used to limit the cornering speed of axis movement, or zero to use the axis jerk limits
 	unsigned int idleCount;								// The number of times Spin was called and had no new moves to process
 
 	uint32_t whenLastMoveAdded;							// The time when we last added a move to the main DDA ring
@@ -292,7 +296,11 @@ private:
 	Deviation latestMeshDeviation;
 
 
+	bool KinematicsCartesianToMotorSteps(const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const noexcept;
+	void KinematicsMotorStepsToCartesian(const int32_t motorPos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const noexcept;
+
 	Kinematics *kinematics;								// What kinematics we are using
+	KinematicsType kinematicsType;						// The type of kinematics, cached so that we can call the coordinate conversion functions of the kinematics class directly
 
 	AxisShaper axisShaper;
 	ExtruderShaper extruderShapers[MaxExtruders];
@@ -36,8 +36,14 @@ const char* const ErrorPagePart2 =
 	"</p>\n"
 	"</body>\n";
 
-HttpResponder::HttpResponder(NetworkResponder *n) noexcept : UploadingNetworkResponder(n)
+HttpResponder::HttpResponder(NetworkResponder *n) noexcept
+	: UploadingNetworkResponder(n), nextHttpResponder(httpResponders), requestsOnConnection(0), keepAlive(false), idleKeepAlive(false), timingRequest(false)
 {
+	for (uint32_t& c : responseTimeCounts)
+	{
+		c = 0;
+	}
+	httpResponders = this;
 }
 
 // Ask the responder to accept this connection, returns true if it did
@@ -48,14 +54,8 @@ bool HttpResponder::Accept(Socket *s, NetworkProtocol protocol) noexcept
 		responderState = ResponderState::reading;
 		skt = s;
 		timer = millis();
-
-		// Reset the parse state variables
-		clientPointer = 0;
-		parseState = HttpParseState::doingCommandWord;
-		numCommandWords = 0;
-		numQualKeys = 0;
-		numHeaderKeys = 0;
-		commandWords[0] = clientMessage;
+		requestsOnConnection = 0;
+		StartReadingRequest();
 
 		if (reprap.Debug(moduleWebserver))
 		{
@@ -66,6 +66,73 @@ bool HttpResponder::Accept(Socket *s, NetworkProtocol protocol) noexcept
 	return false;
 }
 
+// Reset the parse state variables ready to receive a request
+void HttpResponder::StartReadingRequest() noexcept
+{
+	clientPointer = 0;
+	parseState = HttpParseState::doingCommandWord;
+	numCommandWords = 0;
+	numQualKeys = 0;
+	numHeaderKeys = 0;
+	commandWords[0] = clientMessage;
+}
+
+// Return true if the client wants us to keep the connection open after we respond to the current request.
+// HTTP/1.1 connections are persistent unless the client asks us to close them, HTTP/1.0 connections only if the client asks.
+bool HttpResponder::ClientWantsKeepAlive() const noexcept
+{
+	bool wanted = numCommandWords >= 3 && StringEqualsIgnoreCase(commandWords[2], "HTTP/1.1");
+	for (size_t i = 0; i < numHeaderKeys; ++i)
+	{
+		if (StringEqualsIgnoreCase(headers[i].key, "Connection"))
+		{
+			if (StringEqualsIgnoreCase(headers[i].value, "keep-alive"))
+			{
+				wanted = true;
+			}
+			else if (StringEqualsIgnoreCase(headers[i].value, "close"))
+			{
+				wanted = false;
+			}
+			break;
+		}
+	}
+	return wanted;
+}
+
+// Add the Connection header and the blank line that ends the headers
+void HttpResponder::AddConnectionHeader() noexcept
+{
+	if (keepAlive)
+	{
+		outBuf->catf("Connection: keep-alive\r\nKeep-Alive: timeout=%" PRIu32 "\r\n\r\n", HttpReceiveTimeout/1000);
+	}
+	else
+	{
+		outBuf->cat("Connection: close\r\n\r\n");
+	}
+}
+
+// This is called when a persistent connection stops being idle, either because we received another request or the connection was closed
+void HttpResponder::EndIdleKeepAlive() noexcept
+{
+	if (idleKeepAlive)
+	{
+		idleKeepAlive = false;
+		--numIdleKeepAlive;
+	}
+}
+
+void HttpResponder::RecordResponseTime(uint32_t millisTaken) noexcept
+{
+	size_t bucket = 0;
+	while (bucket < ARRAY_SIZE(LatencyBucketLimits) && millisTaken >= LatencyBucketLimits[bucket])
+	{
+		++bucket;
+	}
+	++responseTimeCounts[bucket];
+}
+
 // Do some work, returning true if we did anything significant
 bool HttpResponder::Spin() noexcept
 {
@@ -80,6 +147,7 @@ bool HttpResponder::Spin() noexcept
 			char c;
 			while (skt->ReadChar(c))
 			{
+				EndIdleKeepAlive();
 				if (CharFromClient(c))
 				{
 					timer = millis();		// restart the timeout
@@ -97,7 +165,18 @@ bool HttpResponder::Spin() noexcept
 
 			if (!skt->CanRead() || millis() - timer >= HttpReceiveTimeout)
 			{
-				ConnectionLost();
+				if (idleKeepAlive && skt->CanRead())
+				{
+					// The client didn't send another request on the persistent connection, so close it gracefully in case it is about to send one
+					EndIdleKeepAlive();
+					skt->Close();
+					skt = nullptr;
+					responderState = ResponderState::free;
+				}
+				else
+				{
+					ConnectionLost();
+				}
 				return true;
 			}
 
@@ -453,7 +532,7 @@ bool HttpResponder::CharFromClient(char c) noexcept
 // This may also return true with response == nullptr if we tried to generate a response but ran out of buffers.
 bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen) noexcept
 {
-	keepOpen = false;	// assume we don't want to persist the connection
+	keepOpen = true;	// assume we may persist the connection if the client wants to
 	const char *parameter;
 	if (StringEqualsIgnoreCase(request, "connect") && (parameter = GetKeyValue("password")) != nullptr)
 	{
@@ -500,6 +579,7 @@ bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer
 	else if (StringEqualsIgnoreCase(request, "disconnect"))
 	{
 		response->printf("{\"err\":%d}", (RemoveAuthentication()) ? 0 : 1);
+		keepOpen = false;
 		reprap.GetPlatform().MessageF(LogWarn, "HTTP client %s disconnected\n", IP4String(GetRemoteIP()).c_str());
 	}
 	else if (StringEqualsIgnoreCase(request, "status"))
@@ -684,7 +764,7 @@ bool HttpResponder::SendFileInfo(bool quitEarly) noexcept
 					);
 		outBuf->catf("Content-Length: %u\r\n", (jsonResponse != nullptr) ? jsonResponse->Length() : 0);
 		AddCorsHeader();
-		outBuf->cat("Connection: close\r\n\r\n");
+		AddConnectionHeader();
 		outBuf->Append(jsonResponse);
 		if (outBuf->HadOverflow())
 		{
@@ -695,7 +775,7 @@ bool HttpResponder::SendFileInfo(bool quitEarly) noexcept
 		else
 		{
 			filenameBeingProcessed.Clear();
-			Commit();
+			Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 		}
 	}
 	return gotFileInfo;
@@ -909,8 +989,8 @@ void HttpResponder::SendFile(const char *_ecv_array nameOfFileToSend, bool isWeb
 	}
 
 	outBuf->catf("Content-Length: %lu\r\n", fileToSend->Length());
-	outBuf->cat("Connection: close\r\n\r\n");
-	Commit();
+	AddConnectionHeader();
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 #else
 	RejectMessage("file not found", 404);
 #endif
@@ -953,7 +1033,7 @@ void HttpResponder::SendGCodeReply() noexcept
 					);
 		outBuf->catf("Content-Length: %u\r\n", gcodeReply.DataLength());
 		AddCorsHeader();
-		outBuf->cat("Connection: close\r\n\r\n");
+		AddConnectionHeader();
 		outStack.Append(gcodeReply);
 
 		// Possibly clean up the G-code reply once again
@@ -963,7 +1043,7 @@ void HttpResponder::SendGCodeReply() noexcept
 		}
 	}
 
-	Commit();
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 }
 
 // Send a JSON response to the current command. outBuf is non-null on entry.
@@ -1029,20 +1109,7 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 	}
 
 	// Send the JSON response
-	bool keepOpen = false;
-	if (mayKeepOpen)
-	{
-		// Check that the browser wants to persist the connection too
-		for (size_t i = 0; i < numHeaderKeys; ++i)
-		{
-			if (StringEqualsIgnoreCase(headers[i].key, "Connection"))
-			{
-				// Comment out the following line to disable persistent connections
-				keepOpen = StringEqualsIgnoreCase(headers[i].value, "keep-alive");
-				break;
-			}
-		}
-	}
+	keepAlive = keepAlive && mayKeepOpen;
 
 	// Note that when using RTOS the following response should preferably be small enough to fit in a single buffer.
 	// This is because the current task may get suspended e.g. when reading from SD card to build a file list,
@@ -1058,7 +1125,7 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 	const unsigned int replyLength = (jsonResponse != nullptr) ? jsonResponse->Length() : 0;
 	outBuf->catf("Content-Length: %u\r\n", replyLength);
 	AddCorsHeader();
-	outBuf->catf("Connection: %s\r\n\r\n", keepOpen ? "keep-alive" : "close");
+	AddConnectionHeader();
 	outBuf->Append(jsonResponse);
 
 	if (outBuf->HadOverflow())
@@ -1074,7 +1141,7 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 	}
 
 	// Here if everything is OK
-	Commit(keepOpen ? ResponderState::reading : ResponderState::free, false);
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free, false);
 	if (reprap.Debug(moduleWebserver))
 	{
 		debugPrintf("Sending JSON reply, length %u\n", replyLength);
@@ -1103,6 +1170,16 @@ void HttpResponder::ProcessMessage() noexcept
 
 	responderState = ResponderState::processingRequest;
 	startedProcessingRequestAt = millis();
+	timingRequest = true;
+
+	// Decide whether to keep the connection open after responding. We limit the number of idle persistent connections so that there are always responders free for new connections.
+	++numRequests;
+	if (requestsOnConnection != 0)
+	{
+		++numRequestsOnPersistentConnections;
+	}
+	++requestsOnConnection;
+	keepAlive = ClientWantsKeepAlive() && requestsOnConnection < MaxRequestsPerConnection && numIdleKeepAlive < MaxHttpKeepAliveConnections;
 }
 
 // Process the message received. We have reached the end of the headers.
@@ -1148,7 +1225,7 @@ void HttpResponder::ProcessRequest() noexcept
 				outBuf->catf("Access-Control-Allow-Headers: Content-Type\r\n");
 				AddCorsHeader();
 			}
-			outBuf->cat("\r\n");
+			AddConnectionHeader();
 			if (outBuf->HadOverflow())
 			{
 				OutputBuffer::ReleaseAll(outBuf);
@@ -1156,7 +1233,7 @@ void HttpResponder::ProcessRequest() noexcept
 			}
 			else
 			{
-				Commit();
+				Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 			}
 			return;
 		}
@@ -1198,6 +1275,11 @@ void HttpResponder::ProcessRequest() noexcept
 						postFileExpectedCrc = StrHexToU32(expectedCrc, nullptr);
 					}
 
+					// We read the file data a buffer at a time, which may include the start of the next request, so close the connection after the upload.
+					// Don't include the upload time in the response time statistics.
+					keepAlive = false;
+					timingRequest = false;
+
 					// Start a new file upload
 					if (!StartUpload(FS_PREFIX, filename, (postFileGotCrc) ? OpenMode::writeWithCrc : OpenMode::write, postFileLength))
 					{
@@ -1299,6 +1381,15 @@ void HttpResponder::DoUpload() noexcept
 		(void)CheckAuthenticated();							// uploading may take a long time, so make sure the requester IP is not timed out
 		timer = millis();									// reset the timer
 
+#if SUPPORT_BACKGROUND_WRITES
+		// If the card is still writing the previous buffer and this data won't fit in the current one, leave it in the socket until it can.
+		// This lets the network task get on with other work, and the TCP window stops the client sending too far ahead.
+		if (!dummyUpload && !fileBeingUploaded.CanWriteWithoutWaiting(len))
+		{
+			return;
+		}
+#endif
+
 		const bool ok = dummyUpload || fileBeingUploaded.Write(buffer, len);
 		skt->Taken(len);
 		uploadedBytes += len;
@@ -1372,12 +1463,31 @@ void HttpResponder::CancelUpload() noexcept
 void HttpResponder::SendData() noexcept
 {
 	NetworkResponder::SendData();
+	if (responderState != ResponderState::sending && timingRequest)
+	{
+		RecordResponseTime(millis() - startedProcessingRequestAt);
+		timingRequest = false;
+	}
+
 	if (responderState == ResponderState::reading)
 	{
+		// We have finished sending the response on a persistent connection, so get ready to receive the next request.
+		// If the client has already sent it, it is waiting in the socket.
 		timer = millis();				// restart the timer
+		StartReadingRequest();
+		idleKeepAlive = true;
+		++numIdleKeepAlive;
 	}
 }
 
+// This overrides the version in class UploadingNetworkResponder
+void HttpResponder::ConnectionLost() noexcept
+{
+	EndIdleKeepAlive();
+	timingRequest = false;
+	UploadingNetworkResponder::ConnectionLost();
+}
+
 void HttpResponder::Diagnostics(MessageType mt) const noexcept
 {
 	GetPlatform().MessageF(mt, " HTTP(%d)", (int)responderState);
@@ -1504,7 +1614,33 @@ void HttpResponder::Diagnostics(MessageType mt) const noexcept
 
 /*static*/ void HttpResponder::CommonDiagnostics(MessageType mtype) noexcept
 {
-	GetPlatform().MessageF(mtype, "HTTP sessions: %u of %u\n", numSessions, MaxHttpSessions);
+	Platform& p = GetPlatform();
+	p.MessageF(mtype, "HTTP sessions: %u of %u, requests %" PRIu32 " (%" PRIu32 " on persistent connections), idle persistent connections %u\n",
+					numSessions, MaxHttpSessions, numRequests, numRequestsOnPersistentConnections, numIdleKeepAlive);
+	numRequests = numRequestsOnPersistentConnections = 0;
+
+	// Print the histogram of response times for each responder
+	String<StringLength256> line;
+	line.copy("HTTP response times (ms):");
+	for (uint16_t limit : LatencyBucketLimits)
+	{
+		line.catf(" <%u", limit);
+	}
+	line.catf(" >=%u\n", LatencyBucketLimits[ARRAY_SIZE(LatencyBucketLimits) - 1]);
+	p.Message(mtype, line.c_str());
+
+	unsigned int responderNumber = 0;
+	for (HttpResponder *r = httpResponders; r != nullptr; r = r->nextHttpResponder)
+	{
+		line.printf(" responder %u:", responderNumber++);
+		for (uint32_t& c : r->responseTimeCounts)
+		{
+			line.catf(" %" PRIu32, c);
+			c = 0;
+		}
+		line.cat('\n');
+		p.Message(mtype, line.c_str());
+	}
 }
 
 void HttpResponder::AddCorsHeader() noexcept
@@ -1521,6 +1657,11 @@ HttpResponder::HttpSession HttpResponder::sessions[MaxHttpSessions];
 unsigned int HttpResponder::numSessions = 0;
 unsigned int HttpResponder::clientsServed = 0;
 
+HttpResponder *HttpResponder::httpResponders = nullptr;
+unsigned int HttpResponder::numIdleKeepAlive = 0;
+uint32_t HttpResponder::numRequests = 0;
+uint32_t HttpResponder::numRequestsOnPersistentConnections = 0;
+
 volatile uint16_t HttpResponder::seq = 0;
 volatile OutputStack HttpResponder::gcodeReply;
 Mutex HttpResponder::gcodeReplyMutex;
@@ -30,6 +30,7 @@ public:
 protected:
 	void CancelUpload() noexcept override;
 	void SendData() noexcept override;
+	void ConnectionLost() noexcept override;
 
 private:
 #ifdef __LPC17xx__
@@ -44,6 +45,11 @@ private:
 	static const uint32_t HttpSessionTimeout = 8000;	// HTTP session timeout in milliseconds
 	static const uint32_t MaxFileInfoGetTime = 2000;	// maximum length of time we spend getting file info, to avoid the client timing out (actual time will be a little longer than this)
 	static const uint32_t MaxBufferWaitTime = 1000;		// maximum length of time we spend waiting for a buffer before we discard gcodeReply buffers
+	static const unsigned int MaxRequestsPerConnection = 100;	// close persistent connections after this many requests so that other clients get a turn
+
+	// Upper limits in milliseconds of the response time histogram buckets. There is an extra bucket for longer times.
+	static constexpr uint16_t LatencyBucketLimits[] = { 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+	static constexpr size_t NumLatencyBuckets = ARRAY_SIZE(LatencyBucketLimits) + 1;
 
 	enum class HttpParseState
 	{
@@ -80,6 +86,12 @@ private:
 	bool CheckAuthenticated() noexcept;
 	bool RemoveAuthentication() noexcept;
 
+	void StartReadingRequest() noexcept;
+	bool ClientWantsKeepAlive() const noexcept;
+	void AddConnectionHeader() noexcept;
+	void EndIdleKeepAlive() noexcept;
+	void RecordResponseTime(uint32_t millisTaken) noexcept;
+
 	bool CharFromClient(char c) noexcept;
 	void SendFile(const char *_ecv_array nameOfFileToSend, bool isWebFile) noexcept;
 	void SendGCodeReply() noexcept;
@@ -100,6 +112,12 @@ private:
 	static void RemoveSession(size_t sessionToRemove) noexcept;
 
 	HttpParseState parseState;
+	HttpResponder *nextHttpResponder;				// next responder in the list of HTTP responders, for diagnostics
+	unsigned int requestsOnConnection;				// number of requests we have received on this connection
+	bool keepAlive;									// true if we will keep the connection open after sending the response
+	bool idleKeepAlive;								// true if we are waiting for another request on a persistent connection
+	bool timingRequest;								// true if we are recording how long the current request takes
+	uint32_t responseTimeCounts[NumLatencyBuckets];
 
 	// Buffers for processing HTTP input
 	char clientMessage[WebMessageLength + 3];		// holds the command, qualifier, and headers
@@ -128,6 +146,11 @@ private:
 	static unsigned int numSessions;
 	static unsigned int clientsServed;
 
+	// Persistent connections and response times
+	static HttpResponder *httpResponders;
+	static unsigned int numIdleKeepAlive;			// number of responders waiting for another request on a persistent connection
+	static uint32_t numRequests, numRequestsOnPersistentConnections;
+
 	// Responses from GCodes class
 	static volatile uint16_t seq;					// Sequence number for G-Code replies
 	static volatile OutputStack gcodeReply;
@@ -565,6 +565,9 @@ void Network::Diagnostics(MessageType mtype) noexcept
 
 #if SUPPORT_HTTP
 	HttpResponder::CommonDiagnostics(mtype);
+# if HAS_MASS_STORAGE
+	UploadingNetworkResponder::UploadDiagnostics(mtype);
+# endif
 #endif
 
 	for (NetworkInterface *iface : interfaces)
@@ -104,7 +104,12 @@ void NetworkResponder::SendData() noexcept
 			const int bytesRead = fileBuffer->ReadFromFile(fileBeingSent);
 			if (bytesRead != (int)NetworkBuffer::bufferSize)
 			{
-				// We had a read error or we reached the end of the file
+				// We had a read error or we reached the end of the file.
+				// If we didn't reach the end then the client won't get as many bytes as the Content-Length header promised, so close the connection.
+				if (bytesRead < 0 || fileBeingSent->Position() < fileBeingSent->Length())
+				{
+					stateAfterSending = ResponderState::free;
+				}
 				fileBeingSent->Close();
 				fileBeingSent = nullptr;
 			}
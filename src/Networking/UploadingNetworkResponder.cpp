@@ -9,9 +9,16 @@
 #include "Socket.h"
 #include <Platform/Platform.h>
 
+#if HAS_MASS_STORAGE
+uint32_t UploadingNetworkResponder::numUploads = 0;
+uint32_t UploadingNetworkResponder::uploadBytes = 0;
+uint32_t UploadingNetworkResponder::uploadMillis = 0;
+float UploadingNetworkResponder::lastUploadRate = 0.0;
+#endif
+
 UploadingNetworkResponder::UploadingNetworkResponder(NetworkResponder *n) noexcept : NetworkResponder(n)
 #if HAS_MASS_STORAGE
-	, uploadError(false), dummyUpload(false)
+	, uploadStartTime(0), uploadError(false), dummyUpload(false)
 #endif
 {
 }
@@ -67,11 +74,16 @@ bool UploadingNetworkResponder::StartUpload(const char* folder, const char *file
 			filenameBeingProcessed.Clear();
 			return false;
 		}
+#if SUPPORT_BACKGROUND_WRITES
+		// Have the file writer task write the data to the card, so that we can carry on receiving the next buffer in the meantime
+		(void)file->StartBackgroundWriting();
+#endif
 		fileBeingUploaded.Set(file);
 		dummyUpload = false;
 	}
 	responderState = ResponderState::uploading;
 	uploadError = false;
+	uploadStartTime = millis();
 	return true;
 }
 
@@ -88,10 +100,11 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 		}
 
 		// Check the file length is as expected
-		if (fileLength != 0 && fileBeingUploaded.Length() != fileLength)
+		const FilePosition bytesReceived = fileBeingUploaded.Length();
+		if (fileLength != 0 && bytesReceived != fileLength)
 		{
 			uploadError = true;
-			GetPlatform().MessageF(ErrorMessage, "Uploaded file size is different (%lu vs. expected %lu bytes)\n", fileBeingUploaded.Length(), fileLength);
+			GetPlatform().MessageF(ErrorMessage, "Uploaded file size is different (%lu vs. expected %lu bytes)\n", bytesReceived, fileLength);
 		}
 		else if (gotCrc && expectedCrc != fileBeingUploaded.GetCrc32())
 		{
@@ -126,12 +139,31 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 					// Update the file timestamp if it was specified
 					(void)MassStorage::SetLastModifiedTime(origFilename.c_str(), fileLastModified);
 				}
+
+				// Record the upload speed
+				const uint32_t elapsedMillis = max<uint32_t>(millis() - uploadStartTime, 1);
+				++numUploads;
+				uploadBytes += bytesReceived;
+				uploadMillis += elapsedMillis;
+				lastUploadRate = (float)bytesReceived * 0.001/(float)elapsedMillis;
+
+#if SUPPORT_FILE_INFO_CACHE
+				// Parse the file now, because a client will probably ask for its information soon
+				MassStorage::QueueFileInfoScan(origFilename.c_str());
+#endif
 			}
 			filenameBeingProcessed.Clear();
 		}
 	}
 }
 
+/*static*/ void UploadingNetworkResponder::UploadDiagnostics(MessageType mtype) noexcept
+{
+	GetPlatform().MessageF(mtype, "Uploads: %" PRIu32 " files, %" PRIu32 " bytes at %.2fMbytes/sec, last %.2fMbytes/sec\n",
+							numUploads, uploadBytes, (double)((float)uploadBytes * 0.001/(float)max<uint32_t>(uploadMillis, 1)), (double)lastUploadRate);
+	numUploads = uploadBytes = uploadMillis = 0;
+}
+
 #endif
 
 // End
@@ -12,6 +12,11 @@
 
 class UploadingNetworkResponder : public NetworkResponder
 {
+public:
+#if HAS_MASS_STORAGE
+	static void UploadDiagnostics(MessageType mtype) noexcept;
+#endif
+
 protected:
 	UploadingNetworkResponder(NetworkResponder *n) noexcept;
 
@@ -25,11 +30,18 @@ protected:
 	// File uploads
 	FileData fileBeingUploaded;
 	uint32_t uploadedBytes;								// how many bytes have already been written
+	uint32_t uploadStartTime;							// the millis() value when we started this upload
 	bool uploadError;
 	bool dummyUpload;
 #endif
 
 	String<MaxFilenameLength> filenameBeingProcessed;	// usually the name of the file being uploaded, but also used by HttpResponder and FtpResponder
+
+#if HAS_MASS_STORAGE
+private:
+	static uint32_t numUploads, uploadBytes, uploadMillis;	// statistics for uploads that completed since the last diagnostics report
+	static float lastUploadRate;
+#endif
 };
 
 #endif /* SRC_NETWORKING_UPLOADINGNETWORKRESPONDER_H_ */
@@ -286,6 +286,47 @@ void ObjectExplorationContext::ProvideIndex(int32_t index) THROWS(GCodeException
 	++numIndicesProvided;
 }
 
+// ObjectModelPathCache members
+
+ObjectModelPathCache::Path ObjectModelPathCache::paths[NumPaths];
+size_t ObjectModelPathCache::nextPathToReplace = 0;
+uint32_t ObjectModelPathCache::numHits = 0;
+uint32_t ObjectModelPathCache::numMisses = 0;
+
+// Return the cache entry for the path, replacing the oldest one if it isn't in the cache
+/*static*/ ObjectModelPathCache::Path *ObjectModelPathCache::Find(const char *_ecv_array path) noexcept
+{
+	// FNV-1a hash of the path
+	uint32_t hash = 2166136261u;
+	while (*path != 0)
+	{
+		hash = (hash ^ (uint8_t)*path++) * 16777619u;
+	}
+
+	for (Path& p : paths)
+	{
+		if (p.hash == hash)
+		{
+			return &p;
+		}
+	}
+
+	Path& p = paths[nextPathToReplace];
+	nextPathToReplace = (nextPathToReplace + 1) % NumPaths;
+	p.hash = hash;
+	for (const ObjectModelTableEntry *_ecv_null& e : p.components)
+	{
+		e = nullptr;
+	}
+	return &p;
+}
+
+/*static*/ void ObjectModelPathCache::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Object model path cache hits %" PRIu32 ", misses %" PRIu32 "\n", numHits, numMisses);
+	numHits = numMisses = 0;
+}
+
 // Constructor
 ObjectModel::ObjectModel() noexcept
 {
@@ -296,7 +337,7 @@ ObjectModel::ObjectModel() noexcept
 // Constructor used when reporting the OM as JSON
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, const char *reportFlags, unsigned int initialMaxDepth, size_t initialBufferOffset) noexcept
 	: startMillis(millis()), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
-	  line(-1), column(-1), gb(gbp),
+	  line(-1), column(-1), gb(gbp), cachedPath(nullptr), pathComponentNumber(0),
 	  shortForm(false), wantArrayLength(wal), wantExists(false),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(true), excludeObsolete(true),
@@ -342,6 +383,13 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 				++reportFlags;
 			}
 			break;
+		case 'c':
+			// Report changes since the following generation number. This is handled by RepRap::GetModelResponse, so just skip the number here.
+			while (isdigit(*reportFlags))
+			{
+				++reportFlags;
+			}
+			break;
 		case ' ':
 		case ',':
 			break;
@@ -355,7 +403,7 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 // Constructor when evaluating expressions
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, bool wex, int p_line, int p_col) noexcept
 	: startMillis(millis()), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
-	  line(p_line), column(p_col), gb(gbp),
+	  line(p_line), column(p_col), gb(gbp), cachedPath(nullptr), pathComponentNumber(0),
 	  shortForm(false), wantArrayLength(wal), wantExists(wex),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(false), excludeObsolete(false),
@@ -381,6 +429,22 @@ int32_t ObjectExplorationContext::GetLastIndex() const THROWS(GCodeException)
 	THROW_INTERNAL_ERROR;
 }
 
+// Return the table entry that the current path component resolved to last time, or null if we have none
+const ObjectModelTableEntry *_ecv_null ObjectExplorationContext::GetCachedTableEntry() const noexcept
+{
+	return (cachedPath != nullptr && pathComponentNumber < ObjectModelPathCache::MaxComponents) ? cachedPath->components[pathComponentNumber] : nullptr;
+}
+
+// Record the table entry that the current path component resolved to
+void ObjectExplorationContext::SetCachedTableEntry(const ObjectModelTableEntry *e) noexcept
+{
+	if (cachedPath != nullptr && pathComponentNumber < ObjectModelPathCache::MaxComponents)
+	{
+		cachedPath->components[pathComponentNumber] = e;
+		ObjectModelPathCache::RecordMiss();
+	}
+}
+
 bool ObjectExplorationContext::ShouldReport(const ObjectModelEntryFlags f) const noexcept
 {
 	const bool wanted = includeNonLive
@@ -818,7 +882,7 @@ void ObjectModel::ReportArrayAsJson(OutputBuffer *buf, ObjectExplorationContext&
 		// Support retrieving just part of the array in case it is too large to write all of it to the buffer
 		if (i != startElement)
 		{
-			if (isRootArray && buf->Length() >= (OUTPUT_BUFFER_SIZE * (OUTPUT_BUFFER_COUNT - RESERVED_OUTPUT_BUFFERS))/2)
+			if (isRootArray && buf->Length() >= OutputBuffer::LongResponseSpace)
 			{
 				// We've used half the buffer space already, so stop reporting
 				context.SetNextElement(i);
@@ -879,6 +943,23 @@ const ObjectModelTableEntry* ObjectModel::FindObjectModelTableEntry(const Object
 	return nullptr;
 }
 
+// Return true if the entry is in the specified table of the class
+static bool TableContains(const ObjectModelClassDescriptor *classDescriptor, uint8_t tableNumber, const ObjectModelTableEntry *e) noexcept
+{
+	const uint8_t * const descriptor = classDescriptor->omd;
+	if (tableNumber >= descriptor[0])
+	{
+		return false;
+	}
+
+	const ObjectModelTableEntry *tbl = classDescriptor->omt;
+	for (size_t i = 0; i < tableNumber; ++i)
+	{
+		tbl += descriptor[i + 1];
+	}
+	return e >= tbl && e < tbl + descriptor[tableNumber + 1];
+}
+
 /*static*/ const char* ObjectModel::GetNextElement(const char *id) noexcept
 {
 	while (*id != 0 && *id != '.' && *id != '[' && *id != '^')
@@ -942,25 +1023,55 @@ decrease(strlen(idString))	// recursion variant
 		classDescriptor = GetObjectModelClassDescriptor();
 	}
 
-	while (classDescriptor != nullptr)
+	// If this path component resolved to a table entry last time, use that entry provided that it is in the table we would search and its name matches
+	const ObjectModelTableEntry *_ecv_null e = (isalpha(*idString)) ? context.GetCachedTableEntry() : nullptr;
+	if (e != nullptr)
+	{
+		const ObjectModelClassDescriptor *_ecv_null cd = classDescriptor;
+		while (cd != nullptr && !TableContains(cd, tableNumber, e))
+		{
+			cd = (tableNumber == 0) ? cd->parent : nullptr;
+		}
+		if (cd != nullptr && e->IdCompare(idString) == 0)
+		{
+			classDescriptor = cd;
+			ObjectModelPathCache::RecordHit();
+		}
+		else
+		{
+			e = nullptr;
+		}
+	}
+
+	if (e == nullptr)
 	{
-		const ObjectModelTableEntry * const e = FindObjectModelTableEntry(classDescriptor, tableNumber, idString);
-		if (e != nullptr)
+		while (classDescriptor != nullptr)
 		{
-			if (e->IsObsolete())
+			e = FindObjectModelTableEntry(classDescriptor, tableNumber, idString);
+			if (e != nullptr)
 			{
-				context.SetObsoleteFieldQueried();
+				context.SetCachedTableEntry(e);
+				break;
 			}
-			idString = GetNextElement(idString);
-			const ExpressionValue val = e->func(this, context);
-			context.CheckStack(StackUsage::GetObjectValue_noTable);
-			return GetObjectValue(context, classDescriptor, val, idString);
+			if (tableNumber != 0)
+			{
+				break;
+			}
+			classDescriptor = classDescriptor->parent;			// search parent class object model too
 		}
-		if (tableNumber != 0)
+	}
+
+	if (e != nullptr)
+	{
+		if (e->IsObsolete())
 		{
-			break;
+			context.SetObsoleteFieldQueried();
 		}
-		classDescriptor = classDescriptor->parent;			// search parent class object model too
+		idString = GetNextElement(idString);
+		context.NextPathComponent();
+		const ExpressionValue val = e->func(this, context);
+		context.CheckStack(StackUsage::GetObjectValue_noTable);
+		return GetObjectValue(context, classDescriptor, val, idString);
 	}
 
 	if (context.WantExists())
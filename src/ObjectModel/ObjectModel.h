@@ -214,6 +214,36 @@ enum class ObjectModelEntryFlags : uint8_t
 	obsolete = 8				// entry is deprecated and should not be used any more
 };
 
+// Cache of object model paths that have been resolved into the table entries for their components.
+// Array indices are replaced by '^' in the paths, so a path in a loop over array elements stays in the cache.
+// A cached entry is used only if it belongs to the table being searched and its name matches the path component, so a stale or colliding entry costs a table search but never gives a wrong result.
+class ObjectModelPathCache
+{
+public:
+#if SAME70 || SAME5x
+	static constexpr size_t NumPaths = 16;
+#else
+	static constexpr size_t NumPaths = 4;
+#endif
+	static constexpr size_t MaxComponents = 8;
+
+	struct Path
+	{
+		uint32_t hash;
+		const ObjectModelTableEntry *_ecv_null components[MaxComponents];
+	};
+
+	static Path *Find(const char *_ecv_array path) noexcept;			// return the cache entry for the path, replacing the oldest one if it isn't in the cache
+	static void RecordHit() noexcept { ++numHits; }
+	static void RecordMiss() noexcept { ++numMisses; }
+	static void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	static Path paths[NumPaths];
+	static size_t nextPathToReplace;
+	static uint32_t numHits, numMisses;
+};
+
 // Context passed to object model functions
 class ObjectExplorationContext
 {
@@ -250,6 +280,11 @@ public:
 	bool ObsoleteFieldQueried() const noexcept { return obsoleteFieldQueried; }
 	void SetObsoleteFieldQueried() noexcept { obsoleteFieldQueried = true; }
 
+	void SetCachedPath(ObjectModelPathCache::Path *p) noexcept { cachedPath = p; pathComponentNumber = 0; }
+	const ObjectModelTableEntry *_ecv_null GetCachedTableEntry() const noexcept;
+	void SetCachedTableEntry(const ObjectModelTableEntry *e) noexcept;
+	void NextPathComponent() noexcept { ++pathComponentNumber; }
+
 	GCodeException ConstructParseException(const char *msg) const noexcept;
 	GCodeException ConstructParseException(const char *msg, const char *sparam) const noexcept;
 	void CheckStack(uint32_t calledFunctionStackUsage) const THROWS(GCodeException);
@@ -269,6 +304,8 @@ private:
 	int line;
 	int column;
 	const GCodeBuffer *_ecv_null gb;
+	ObjectModelPathCache::Path *_ecv_null cachedPath;	// cached table entries for the path being looked up, or null
+	unsigned int pathComponentNumber;				// index of the path component being looked up
 	unsigned int shortForm : 1,
 				wantArrayLength : 1,
 				wantExists : 1,
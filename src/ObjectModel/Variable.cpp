@@ -7,6 +7,7 @@
 
 #include "Variable.h"
 #include <Platform/OutputMemory.h>
+#include <Movement/StepTimer.h>
 
 Variable::Variable(const char *str, ExpressionValue pVal, int8_t pScope) noexcept : name(str), val(pVal), scope(pScope)
 {
@@ -18,43 +19,158 @@ Variable::~Variable()
 	val.Release();
 }
 
-Variable* VariableSet::Lookup(const char *str) noexcept
+// Return true if this variable has the specified name. Comparing the hash first saves locking the string heap to compare the names of most variables.
+bool VariableSet::LinkedVariable::Matches(const char *_ecv_array str, uint32_t hash) const noexcept
+{
+	if (nameHash != hash)
+	{
+		return false;
+	}
+	auto vname = v.GetName();
+	return strcmp(vname.Ptr(), str) == 0;
+}
+
+// FNV-1a hash of a variable name
+/*static*/ uint32_t VariableSet::Hash(const char *_ecv_array str) noexcept
+{
+	uint32_t h = 2166136261u;
+	while (*str != 0)
+	{
+		h = (h ^ (uint8_t)*str++) * 16777619u;
+	}
+	return h;
+}
+
+// Find the visible variable with the specified name
+VariableSet::LinkedVariable *_ecv_null VariableSet::Find(const char *_ecv_array str) const noexcept
 {
-	LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	const uint32_t hash = Hash(str);
+	if (index == nullptr)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
+		return FindInList(str, hash);
+	}
+
+	const unsigned int mask = indexSize - 1;
+	for (unsigned int i = hash & mask; index[i] != nullptr; i = (i + 1) & mask)
+	{
+		if (index[i]->Matches(str, hash))
 		{
-			return &(lv->v);
+			return index[i];
 		}
 	}
 	return nullptr;
 }
 
-const Variable* VariableSet::Lookup(const char *str) const noexcept
+VariableSet::LinkedVariable *_ecv_null VariableSet::FindInList(const char *_ecv_array str, uint32_t hash) const noexcept
 {
-	const LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
+		if (lv->Matches(str, hash))
 		{
-			return &(lv->v);
+			return lv;
 		}
 	}
 	return nullptr;
 }
 
+// Add a variable to the index. If there is already a variable with the same name in the index, replace it if 'replace' is true, else leave it.
+void VariableSet::AddToIndex(LinkedVariable *lv, bool replace) noexcept
+{
+	const unsigned int mask = indexSize - 1;
+	unsigned int i = lv->nameHash & mask;
+	while (index[i] != nullptr)
+	{
+		// Only compare the names if the hashes match. Copy our name first, so that we don't hold the string heap lock twice.
+		if (index[i]->nameHash == lv->nameHash)
+		{
+			String<MaxVariableNameLength> ourName;
+			ourName.copy(lv->v.GetName().Ptr());
+			if (index[i]->Matches(ourName.c_str(), lv->nameHash))
+			{
+				if (replace)
+				{
+					index[i] = lv;
+				}
+				return;
+			}
+		}
+		i = (i + 1) & mask;
+	}
+	index[i] = lv;
+}
+
+// Rebuild the index after variables have been added or removed, or release it if we no longer need it
+void VariableSet::RebuildIndex() noexcept
+{
+	if (numVariables <= MaxVariablesWithoutIndex)
+	{
+		ReleaseIndex();
+		return;
+	}
+
+	// Keep the index at most half full so that probe sequences stay short
+	unsigned int newSize = MinIndexSize;
+	while (newSize < 2 * numVariables)
+	{
+		newSize <<= 1;
+	}
+
+	if (newSize != indexSize)
+	{
+		ReleaseIndex();
+		index = new LinkedVariable*[newSize];
+		indexSize = newSize;
+	}
+	for (unsigned int i = 0; i < indexSize; ++i)
+	{
+		index[i] = nullptr;
+	}
+
+	// The list has the newest variables first, so don't let older variables replace them
+	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
+	{
+		AddToIndex(lv, false);
+	}
+}
+
+void VariableSet::ReleaseIndex() noexcept
+{
+	delete[] index;
+	index = nullptr;
+	indexSize = 0;
+}
+
+Variable* VariableSet::Lookup(const char *str) noexcept
+{
+	LinkedVariable * const lv = Find(str);
+	return (lv == nullptr) ? nullptr : &(lv->v);
+}
+
+const Variable* VariableSet::Lookup(const char *str) const noexcept
+{
+	const LinkedVariable * const lv = Find(str);
+	return (lv == nullptr) ? nullptr : &(lv->v);
+}
+
 void VariableSet::InsertNew(const char *str, ExpressionValue pVal, int8_t pScope) noexcept
 {
-	LinkedVariable * const toInsert = new LinkedVariable(str, pVal, pScope, root);
+	LinkedVariable * const toInsert = new LinkedVariable(str, Hash(str), pVal, pScope, root);
 	root = toInsert;
+	++numVariables;
+	if (index != nullptr && 2 * numVariables <= indexSize)
+	{
+		AddToIndex(toInsert, true);
+	}
+	else if (numVariables > MaxVariablesWithoutIndex)
+	{
+		RebuildIndex();
+	}
 }
 
 // Remove all variables with a scope greater than the parameter
 void VariableSet::EndScope(uint8_t blockNesting) noexcept
 {
+	bool removed = false;
 	LinkedVariable *prev = nullptr;
 	for (LinkedVariable *lv = root; lv != nullptr; )
 	{
@@ -71,6 +187,8 @@ void VariableSet::EndScope(uint8_t blockNesting) noexcept
 				prev->next = lv;
 			}
 			delete temp;
+			--numVariables;
+			removed = true;
 		}
 		else
 		{
@@ -78,15 +196,20 @@ void VariableSet::EndScope(uint8_t blockNesting) noexcept
 			lv = lv->next;
 		}
 	}
+
+	if (removed && index != nullptr)
+	{
+		RebuildIndex();
+	}
 }
 
 void VariableSet::Delete(const char *str) noexcept
 {
+	const uint32_t hash = Hash(str);
 	LinkedVariable *prev = nullptr;
 	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
+		if (lv->Matches(str, hash))
 		{
 			if (prev == nullptr)
 			{
@@ -97,6 +220,11 @@ void VariableSet::Delete(const char *str) noexcept
 				prev->next = lv->next;
 			}
 			delete lv;
+			--numVariables;
+			if (index != nullptr)
+			{
+				RebuildIndex();								// an older variable with the same name may now be visible
+			}
 			break;
 		}
 		prev = lv;
@@ -105,12 +233,14 @@ void VariableSet::Delete(const char *str) noexcept
 
 void VariableSet::Clear() noexcept
 {
+	ReleaseIndex();
 	while (root != nullptr)
 	{
 		LinkedVariable *lv = root;
 		root = lv->next;
 		delete lv;
 	}
+	numVariables = 0;
 }
 
 VariableSet::~VariableSet()
@@ -123,7 +253,13 @@ void VariableSet::AssignFrom(VariableSet& other) noexcept
 {
 	Clear();
 	root = other.root;
+	index = other.index;
+	indexSize = other.indexSize;
+	numVariables = other.numVariables;
 	other.root = nullptr;
+	other.index = nullptr;
+	other.indexSize = 0;
+	other.numVariables = 0;
 }
 
 void VariableSet::IterateWhile(function_ref<bool(unsigned int, const Variable&) /*noexcept*/ > func) const noexcept
@@ -139,4 +275,59 @@ void VariableSet::IterateWhile(function_ref<bool(unsigned int, const Variable&)
 	}
 }
 
+// Time looking up variables in sets of different sizes, using the index and searching the list.
+// The list nodes are kept on the freelist for reuse when the test variables are deleted, rather than being returned to the heap.
+// So we use no more variables than a macro might reasonably create, one set too small to be indexed and one that is indexed.
+/*static*/ void VariableSet::TimeLookups(const StringRef& reply) noexcept
+{
+	constexpr unsigned int NumLookups = 300;
+	static constexpr unsigned int SetSizes[] = { MaxVariablesWithoutIndex, 32 };
+
+	reply.copy("Lookup time per variable (indexed/list):");
+	for (unsigned int numVars : SetSizes)
+	{
+		VariableSet vars;
+		String<StringLength20> varName;
+		for (unsigned int i = 0; i < numVars; ++i)
+		{
+			varName.printf("var%u", i);
+			vars.InsertNew(varName.c_str(), ExpressionValue((int32_t)i), 0);
+		}
+
+		// Look up the oldest, a middle and the newest variable in turn. The oldest one is the slowest to find in the list.
+		String<StringLength20> names[3];
+		names[0].copy("var0");
+		names[1].printf("var%u", numVars/2);
+		names[2].printf("var%u", numVars - 1);
+		unsigned int numFound = 0;
+
+		uint32_t startTicks = StepTimer::GetTimerTicks();
+		for (unsigned int i = 0; i < NumLookups; ++i)
+		{
+			if (vars.Find(names[i % 3].c_str()) != nullptr)
+			{
+				++numFound;
+			}
+		}
+		const uint32_t indexedTicks = StepTimer::GetTimerTicks() - startTicks;
+
+		startTicks = StepTimer::GetTimerTicks();
+		for (unsigned int i = 0; i < NumLookups; ++i)
+		{
+			const char *_ecv_array const str = names[i % 3].c_str();
+			if (vars.FindInList(str, Hash(str)) != nullptr)
+			{
+				++numFound;
+			}
+		}
+		const uint32_t listTicks = StepTimer::GetTimerTicks() - startTicks;
+
+		reply.catf(" %u vars %.2f/%.2fus%s", numVars,
+					(double)((float)indexedTicks * StepClocksToMillis * 1000.0/(float)NumLookups),
+					(double)((float)listTicks * StepClocksToMillis * 1000.0/(float)NumLookups),
+					(numFound == 2 * NumLookups) ? "" : " (lookup failed)");
+	}
+	StringHandle::GarbageCollect();											// recover the string heap space used by the names
+}
+
 // End
@@ -33,11 +33,12 @@ private:
 };
 
 // Class to represent a collection of variables.
-// For now this is just a linked list, but it could be changed to a hash table for faster lookup and insertion.
+// The variables are kept in a linked list with the most recently created one first, which defines the iteration order and which variable of a given name is visible.
+// When there are more than a few variables we also keep an open-addressed hash index of the visible variable for each name, so that lookups don't compare every name.
 class VariableSet
 {
 public:
-	VariableSet() noexcept : root(nullptr) { }
+	VariableSet() noexcept : root(nullptr), index(nullptr), indexSize(0), numVariables(0) { }
 	~VariableSet();
 	VariableSet(const VariableSet&) = delete;
 	VariableSet& operator=(const VariableSet& other) = delete;
@@ -54,18 +55,37 @@ public:
 
 	void IterateWhile(function_ref<bool(unsigned int index, const Variable& v) /*noexcept*/ > func) const noexcept;
 
+	static void TimeLookups(const StringRef& reply) noexcept;
+
 private:
 	struct LinkedVariable
 	{
 		DECLARE_FREELIST_NEW_DELETE(LinkedVariable)
 
-		LinkedVariable(const char *_ecv_array str, ExpressionValue pVal, int8_t pScope, LinkedVariable *p_next) : next(p_next), v(str, pVal, pScope) {}
+		LinkedVariable(const char *_ecv_array str, uint32_t hash, ExpressionValue pVal, int8_t pScope, LinkedVariable *p_next) : next(p_next), nameHash(hash), v(str, pVal, pScope) {}
+
+		bool Matches(const char *_ecv_array str, uint32_t hash) const noexcept;
 
 		LinkedVariable * null next;
+		uint32_t nameHash;
 		Variable v;
 	};
 
+	static uint32_t Hash(const char *_ecv_array str) noexcept;
+
+	LinkedVariable *_ecv_null Find(const char *_ecv_array str) const noexcept;
+	LinkedVariable *_ecv_null FindInList(const char *_ecv_array str, uint32_t hash) const noexcept;
+	void AddToIndex(LinkedVariable *lv, bool replace) noexcept;
+	void RebuildIndex() noexcept;
+	void ReleaseIndex() noexcept;
+
+	static constexpr unsigned int MaxVariablesWithoutIndex = 8;
+	static constexpr unsigned int MinIndexSize = 32;		// must be a power of 2 and at least twice MaxVariablesWithoutIndex
+
 	LinkedVariable * null root;
+	LinkedVariable * null * null index;						// the hash index, or nullptr if we have too few variables to need one
+	unsigned int indexSize;									// the number of slots in the index, always a power of 2 so that we can mask the hash
+	unsigned int numVariables;
 };
 
 #endif /* SRC_GCODES_VARIABLE_H_ */
@@ -7,6 +7,11 @@
  * The string heap uses two structures.
  * Each index block is an array of pointers to the actual data. This allows the data to be moved when the heap is compacted. The first pointer in the block points to the next index block.
  * The heap itself is a sequence of blocks. Each block comprises a 2-byte length count followed by the null-terminated string. The length count is always even and the lowest bit is set if the block is free.
+ *
+ * Allocation lengths are rounded up to a small number of size classes. When a block is freed it is pushed onto the free list for its size class, so that it can be reused
+ * by the next allocation of the same size class without any garbage collection. A free block holds the pointer to the next free block in its data area.
+ * Blocks are freed by tasks that hold only the read lock, so pushing onto a free list is done atomically. Blocks are only taken from the free lists by tasks that hold the write lock.
+ * Compaction removes free blocks from the free lists. It is done either for the whole heap when an allocation fails, or one heap block at a time from StringHandle::Spin.
  */
 
 #include "Heap.h"
@@ -14,6 +19,7 @@
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
 #include <General/String.h>
+#include <Movement/StepTimer.h>
 #include <atomic>
 
 #define CHECK_HANDLES	(1)							// set nonzero to check that handles are valid before dereferencing them
@@ -21,6 +27,13 @@
 constexpr size_t IndexBlockSlots = 99;				// number of 4-byte handles per index block, plus one for link to next index block
 constexpr size_t HeapBlockSize = 2048;				// the size of each heap block
 
+// Allocation size classes. Allocations larger than the biggest size class are rounded up to an even length and share the last free list.
+constexpr uint16_t SizeClassLengths[] = { 4, 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+constexpr size_t NumFreeLists = ARRAY_SIZE(SizeClassLengths) + 1;
+
+constexpr size_t IncrementalGcThreshold = HeapBlockSize/4;		// how much recyclable space we need before doing incremental garbage collection
+constexpr uint32_t GcSliceTicks = (200 * StepClockRate)/1000000;	// the time after which incremental garbage collection stops compacting more blocks (200us)
+
 struct StorageSpace
 {
 	uint16_t length;
@@ -70,6 +83,51 @@ size_t StringHandle::heapAllocated = 0;
 size_t StringHandle::heapUsed = 0;
 std::atomic<size_t> StringHandle::heapToRecycle = 0;
 unsigned int StringHandle::gcCyclesDone = 0;
+unsigned int StringHandle::gcSlicesDone = 0;
+uint32_t StringHandle::maxGcPauseTicks = 0;
+uint32_t StringHandle::numReused = 0;
+HeapBlock *StringHandle::nextBlockToCompact = nullptr;
+
+static std::atomic<StorageSpace*> freeLists[NumFreeLists];
+
+// Return the allocated length for a requested length, which must be at least 1
+static inline size_t RoundToSizeClass(size_t length) noexcept
+{
+	for (uint16_t classLength : SizeClassLengths)
+	{
+		if (length <= classLength)
+		{
+			return classLength;
+		}
+	}
+	return min<size_t>((length + 1) & (~1u), HeapBlockSize - sizeof(StorageSpace::length));	// round to an even length to keep things aligned and limit to max size
+}
+
+// Return the index of the free list for an allocated length
+static inline size_t GetFreeListIndex(size_t length) noexcept
+{
+	for (size_t i = 0; i < ARRAY_SIZE(SizeClassLengths); ++i)
+	{
+		if (length == SizeClassLengths[i])
+		{
+			return i;
+		}
+	}
+	return NumFreeLists - 1;
+}
+
+// Get and set the link to the next free block. These are not aligned to 4 bytes, so we use memcpy.
+static inline StorageSpace *GetNextFree(const StorageSpace *space) noexcept
+{
+	StorageSpace *next;
+	memcpy(&next, space->data, sizeof(next));
+	return next;
+}
+
+static inline void SetNextFree(StorageSpace *space, StorageSpace *next) noexcept
+{
+	memcpy(space->data, &next, sizeof(next));
+}
 
 /*static*/ void StringHandle::GarbageCollect() noexcept
 {
@@ -77,80 +135,221 @@ unsigned int StringHandle::gcCyclesDone = 0;
 	GarbageCollectInternal();
 }
 
+// Do some incremental garbage collection if there is enough space to recycle. Called by the main task.
+/*static*/ void StringHandle::Spin() noexcept
+{
+	if (heapToRecycle >= IncrementalGcThreshold)
+	{
+		WriteLocker locker(heapLock);
+		GarbageCollectIncremental();
+	}
+}
+
 /*static*/ void StringHandle::GarbageCollectInternal() noexcept
 {
 #if CHECK_HANDLES
 	RRF_ASSERT(heapLock.GetWriteLockOwner() == TaskBase::GetCallerTaskHandle());
 #endif
 
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
 	heapUsed = 0;
-	for (HeapBlock *currentBlock = heapRoot; currentBlock != nullptr; )
+	for (HeapBlock *currentBlock = heapRoot; currentBlock != nullptr; currentBlock = currentBlock->next)
+	{
+		(void)CompactBlock(currentBlock);
+		heapUsed += currentBlock->allocated;
+	}
+
+	// All the free blocks have gone, so clear the free lists
+	for (std::atomic<StorageSpace*>& head : freeLists)
+	{
+		head = nullptr;
+	}
+
+	heapToRecycle = 0;
+	nextBlockToCompact = nullptr;
+	++gcCyclesDone;
+	RecordGcPause(startTicks);
+}
+
+// Compact heap blocks starting from where we left off last time, until we have spent long enough. Always compact at least one block.
+/*static*/ void StringHandle::GarbageCollectIncremental() noexcept
+{
+#if CHECK_HANDLES
+	RRF_ASSERT(heapLock.GetWriteLockOwner() == TaskBase::GetCallerTaskHandle());
+#endif
+
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	do
 	{
-		// Skip any used blocks at the start because they won't be moved
-		char *p = currentBlock->data;
-		while (p < currentBlock->data + currentBlock->allocated)
+		if (nextBlockToCompact == nullptr)
 		{
-			const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-			if (len & 1u)					// if this slot has been marked as free
+			nextBlockToCompact = heapRoot;
+			if (nextBlockToCompact == nullptr)
 			{
 				break;
 			}
-			p += len + sizeof(StorageSpace::length);
 		}
 
-		if (p < currentBlock->data + currentBlock->allocated)					// if we found an unused block before we reached the end
+		HeapBlock * const currentBlock = nextBlockToCompact;
+		nextBlockToCompact = currentBlock->next;
+		RemoveFromFreeLists(currentBlock);
+		const size_t reclaimed = CompactBlock(currentBlock);
+		heapUsed -= reclaimed;
+		heapToRecycle -= reclaimed;
+		if (nextBlockToCompact == nullptr)
 		{
-			char* startSkip = p;
+			++gcCyclesDone;												// we have been through all the heap blocks
+		}
+	} while (heapToRecycle != 0 && StepTimer::GetTimerTicks() - startTicks < GcSliceTicks);
+
+	++gcSlicesDone;
+	RecordGcPause(startTicks);
+}
+
+// Move all the used storage in a heap block down to the start of the block, returning the number of bytes reclaimed.
+// Any free storage in this block must not be on the free lists.
+/*static*/ size_t StringHandle::CompactBlock(HeapBlock *currentBlock) noexcept
+{
+	const size_t oldAllocated = currentBlock->allocated;
 
-			for (;;)
+	// Skip any used blocks at the start because they won't be moved
+	char *p = currentBlock->data;
+	while (p < currentBlock->data + currentBlock->allocated)
+	{
+		const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
+		if (len & 1u)					// if this slot has been marked as free
+		{
+			break;
+		}
+		p += len + sizeof(StorageSpace::length);
+	}
+
+	if (p < currentBlock->data + currentBlock->allocated)					// if we found an unused block before we reached the end
+	{
+		char* startSkip = p;
+
+		for (;;)
+		{
+			// Find the end of the unused blocks
+			while (p < currentBlock->data + currentBlock->allocated)
 			{
-				// Find the end of the unused blocks
+				const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
+				if ((len & 1u) == 0)
+				{
+					break;
+				}
+				p += (len & ~1u) + sizeof(StorageSpace::length);
+			}
+
+			if (p >= currentBlock->data + currentBlock->allocated)
+			{
+				currentBlock->allocated = startSkip - currentBlock->data;	// the unused blocks were at the end so just change the allocated size
+				break;
+			}
+			else
+			{
+				// Find all the contiguous blocks
+				char *startUsed = p;
+				unsigned int numHandlesToAdjust = 0;
 				while (p < currentBlock->data + currentBlock->allocated)
 				{
 					const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-					if ((len & 1u) == 0)
+					if (len & 1u)
 					{
 						break;
 					}
-					p += (len & ~1u) + sizeof(StorageSpace::length);
+					++numHandlesToAdjust;
+					p += len + sizeof(StorageSpace::length);
 				}
 
-				if (p >= currentBlock->data + currentBlock->allocated)
+				// Move the contiguous blocks down
+				memmove(startSkip, startUsed, p - startUsed);
+				//TODO make this more efficient by building up a small table of several adjustments, so we need to make fewer passes through the index
+				AdjustHandles(startUsed, p, startUsed - startSkip, numHandlesToAdjust);
+				startSkip += p - startUsed;
+			}
+		}
+	}
+
+	return oldAllocated - currentBlock->allocated;
+}
+
+/*static*/ void StringHandle::RecordGcPause(uint32_t startTicks) noexcept
+{
+	const uint32_t ticks = StepTimer::GetTimerTicks() - startTicks;
+	if (ticks > maxGcPauseTicks)
+	{
+		maxGcPauseTicks = ticks;
+	}
+}
+
+// Push a block that is no longer used onto the free list for its size, marking it as free. Caller must have at least a read lock.
+/*static*/ void StringHandle::AddToFreeList(StorageSpace *space) noexcept
+{
+	std::atomic<StorageSpace*>& head = freeLists[GetFreeListIndex(space->length)];
+	space->length |= 1;											// flag the space as unused
+	StorageSpace *next = head.load();
+	do
+	{
+		SetNextFree(space, next);
+	} while (!head.compare_exchange_weak(next, space));
+}
+
+// Take a free block of the required allocated length from the free lists, or return nullptr if there isn't one. Must own the write lock when calling this.
+// Allocations that are larger than all the size classes may be given a longer block than they asked for.
+/*static*/ StorageSpace *StringHandle::TakeFreeSpace(size_t length) noexcept
+{
+	std::atomic<StorageSpace*>& head = freeLists[GetFreeListIndex(length)];
+	StorageSpace *prev = nullptr;
+	for (StorageSpace *space = head.load(); space != nullptr; space = GetNextFree(space))
+	{
+		if ((space->length & ~1u) >= length)
+		{
+			if (prev == nullptr)
+			{
+				head = GetNextFree(space);
+			}
+			else
+			{
+				SetNextFree(prev, GetNextFree(space));
+			}
+			space->length &= ~1u;
+			heapToRecycle -= space->length + sizeof(StorageSpace::length);
+			++numReused;
+			return space;
+		}
+		prev = space;
+	}
+	return nullptr;
+}
+
+// Remove all the free blocks that are in the specified heap block from the free lists. Must own the write lock when calling this.
+/*static*/ void StringHandle::RemoveFromFreeLists(const HeapBlock *block) noexcept
+{
+	for (std::atomic<StorageSpace*>& head : freeLists)
+	{
+		StorageSpace *prev = nullptr;
+		for (StorageSpace *space = head.load(); space != nullptr; )
+		{
+			StorageSpace * const next = GetNextFree(space);
+			if ((const char *)space >= block->data && (const char *)space < block->data + HeapBlockSize)
+			{
+				if (prev == nullptr)
 				{
-					currentBlock->allocated = startSkip - currentBlock->data;	// the unused blocks were at the end so just change the allocated size
-					break;
+					head = next;
 				}
 				else
 				{
-					// Find all the contiguous blocks
-					char *startUsed = p;
-					unsigned int numHandlesToAdjust = 0;
-					while (p < currentBlock->data + currentBlock->allocated)
-					{
-						const size_t len = reinterpret_cast<StorageSpace*>(p)->length;
-						if (len & 1u)
-						{
-							break;
-						}
-						++numHandlesToAdjust;
-						p += len + sizeof(StorageSpace::length);
-					}
-
-					// Move the contiguous blocks down
-					memmove(startSkip, startUsed, p - startUsed);
-					//TODO make this more efficient by building up a small table of several adjustments, so we need to make fewer passes through the index
-					AdjustHandles(startUsed, p, startUsed - startSkip, numHandlesToAdjust);
-					startSkip += p - startUsed;
+					SetNextFree(prev, next);
 				}
 			}
+			else
+			{
+				prev = space;
+			}
+			space = next;
 		}
-
-		heapUsed += currentBlock->allocated;
-		currentBlock = currentBlock->next;
 	}
-
-	heapToRecycle = 0;
-	++gcCyclesDone;
 }
 
 // Find all handles pointing to storage between startAddr and endAddr and move the pointers down by amount moveDown
@@ -299,7 +498,14 @@ unsigned int StringHandle::gcCyclesDone = 0;
 	RRF_ASSERT(heapLock.GetWriteLockOwner() == TaskBase::GetCallerTaskHandle());
 #endif
 
-	length = min<size_t>((length + 1) & (~1u), HeapBlockSize - sizeof(StorageSpace::length));	// round to an even length to keep things aligned and limit to max size
+	length = RoundToSizeClass(length);
+
+	// Try to reuse a block that has been freed
+	StorageSpace * const reused = TakeFreeSpace(length);
+	if (reused != nullptr)
+	{
+		return reused;
+	}
 
 	bool collected = false;
 	do
@@ -423,7 +629,7 @@ void StringHandle::InternalDelete() noexcept
 	if (--slotPtr->refCount == 0)
 	{
 		heapToRecycle += slotPtr->storage->length + sizeof(StorageSpace::length);
-		slotPtr->storage->length |= 1;									// flag the space as unused
+		AddToFreeList(slotPtr->storage);					// flag the space as unused so that it can be reused or recycled
 		slotPtr->storage = nullptr;							// release the handle entry
 		--handlesUsed;
 	}
@@ -494,9 +700,21 @@ size_t StringHandle::GetLength() const noexcept
 	{
 		temp.copy("Heap OK");
 	}
-	temp.catf(", handles allocated/used %u/%u, heap memory allocated/used/recyclable %u/%u/%u, gc cycles %u\n",
-					handlesAllocated, (unsigned int)handlesUsed, heapAllocated, heapUsed, (unsigned int)heapToRecycle, gcCyclesDone);
+	temp.catf(", handles allocated/used %u/%u, heap memory allocated/used/recyclable %u/%u/%u, fragmentation %.1f%%, reused %" PRIu32 ", gc cycles %u, slices %u, max pause %" PRIu32 "us\n",
+					handlesAllocated, (unsigned int)handlesUsed, heapAllocated, heapUsed, (unsigned int)heapToRecycle, (double)GetFragmentation(),
+					numReused, gcCyclesDone, gcSlicesDone, GetMaxGcPauseMicroseconds());
 	p.Message(mt, temp.c_str());
+	maxGcPauseTicks = 0;
+}
+
+/*static*/ float StringHandle::GetFragmentation() noexcept
+{
+	return (heapUsed == 0) ? 0.0 : (float)heapToRecycle * 100.0/(float)heapUsed;
+}
+
+/*static*/ uint32_t StringHandle::GetMaxGcPauseMicroseconds() noexcept
+{
+	return (uint32_t)((float)maxGcPauseTicks * StepClocksToMillis * 1000.0);
 }
 
 // AutoStringHandle members
@@ -40,9 +40,14 @@ public:
 	void Assign(const char *s) noexcept;
 
 	static void GarbageCollect() noexcept;
+	static void Spin() noexcept;												// do some incremental garbage collection if it is worthwhile
 //	static size_t GetWastedSpace() noexcept { return spaceToRecycle; }
 //	static size_t GetIndexSpace() noexcept { return totalIndexSpace; }
-//	static size_t GetHeapSpace() noexcept { return totalHeapSpace; }
+	static size_t GetHeapSpace() noexcept { return heapAllocated; }
+	static size_t GetHeapUsed() noexcept { return heapUsed; }
+	static float GetFragmentation() noexcept;									// the percentage of the used heap that is waiting to be recycled
+	static unsigned int GetGcCycles() noexcept { return gcCyclesDone; }
+	static uint32_t GetMaxGcPauseMicroseconds() noexcept;
 	static bool CheckIntegrity(const StringRef& errmsg) noexcept;
 	static void Diagnostics(MessageType mt, Platform& p) noexcept;
 
@@ -52,7 +57,13 @@ protected:
 
 	static IndexSlot *AllocateHandle() noexcept;
 	static StorageSpace *AllocateSpace(size_t length) noexcept;
+	static StorageSpace *TakeFreeSpace(size_t length) noexcept;
+	static void AddToFreeList(StorageSpace *space) noexcept;
+	static void RemoveFromFreeLists(const HeapBlock *block) noexcept;
 	static void GarbageCollectInternal() noexcept;
+	static void GarbageCollectIncremental() noexcept;
+	static size_t CompactBlock(HeapBlock *block) noexcept;
+	static void RecordGcPause(uint32_t startTicks) noexcept;
 	static void AdjustHandles(char *startAddr, char *endAddr, size_t moveDown, unsigned int numHandles) noexcept;
 
 	IndexSlot * null slotPtr;
@@ -66,6 +77,10 @@ protected:
 	static size_t heapUsed;
 	static std::atomic<size_t> heapToRecycle;
 	static unsigned int gcCyclesDone;
+	static unsigned int gcSlicesDone;
+	static uint32_t maxGcPauseTicks;
+	static uint32_t numReused;
+	static HeapBlock *nextBlockToCompact;
 };
 
 // Version of StringHandle that updates the reference counts automatically
@@ -13,6 +13,9 @@
 /*static*/ OutputBuffer * volatile OutputBuffer::freeOutputBuffers = nullptr;		// Messages may also be sent by ISRs,
 /*static*/ volatile size_t OutputBuffer::usedOutputBuffers = 0;						// so make these volatile.
 /*static*/ volatile size_t OutputBuffer::maxUsedOutputBuffers = 0;
+/*static*/ OutputBuffer * volatile OutputBuffer::freeLargeOutputBuffers = nullptr;
+/*static*/ volatile size_t OutputBuffer::usedLargeOutputBuffers = 0;
+/*static*/ volatile size_t OutputBuffer::maxUsedLargeOutputBuffers = 0;
 
 //*************************************************************************************************
 // OutputBuffer class implementation
@@ -177,34 +180,35 @@ size_t OutputBuffer::copy(const char *_ecv_array src, size_t len) noexcept
 	return cat(src, len);
 }
 
-size_t OutputBuffer::cat(const char c) noexcept
+// Add another buffer to the end of the chain, returning true if successful
+bool OutputBuffer::Extend() noexcept
 {
-	// See if we can append a char
-	if (last->dataLength == OUTPUT_BUFFER_SIZE)
+	OutputBuffer *nextBuffer;
+	if (!Allocate(nextBuffer, true))
 	{
-		// No - allocate a new item and copy the data
-		OutputBuffer *nextBuffer;
-		if (!Allocate(nextBuffer))
-		{
-			// We cannot store any more data
-			hadOverflow = true;
-			return 0;
-		}
-		nextBuffer->references = references;
-		nextBuffer->copy(c);
+		// We cannot store any more data
+		hadOverflow = true;
+		return false;
+	}
+	nextBuffer->references = references;
 
-		// Link the new item to this list
-		last->next = nextBuffer;
-		for (OutputBuffer *item = this; item != nextBuffer; item = item->Next())
-		{
-			item->last = nextBuffer;
-		}
+	// Link the new item to this list
+	last->next = nextBuffer;
+	for (OutputBuffer *item = this; item != nextBuffer; item = item->Next())
+	{
+		item->last = nextBuffer;
 	}
-	else
+	return true;
+}
+
+size_t OutputBuffer::cat(const char c) noexcept
+{
+	// See if we can append a char, if not then allocate a new item
+	if (last->dataLength == last->capacity && !Extend())
 	{
-		// Yes - we have enough space left
-		last->data[last->dataLength++] = c;
+		return 0;
 	}
+	last->data[last->dataLength++] = c;
 	return 1;
 }
 
@@ -223,25 +227,12 @@ size_t OutputBuffer::cat(const char *_ecv_array src, size_t len) noexcept
 	size_t copied = 0;
 	while (copied < len)
 	{
-		if (last->dataLength == OUTPUT_BUFFER_SIZE)
+		if (last->dataLength == last->capacity && !Extend())
 		{
-			// The last buffer is full
-			OutputBuffer *nextBuffer;
-			if (!Allocate(nextBuffer))
-			{
-				// We cannot store any more data, stop here
-				hadOverflow = true;
-				break;
-			}
-			nextBuffer->references = references;
-			last->next = nextBuffer;
-			last = nextBuffer->last;
-			for (OutputBuffer *item = Next(); item != nextBuffer; item = item->Next())
-			{
-				item->last = last;
-			}
+			// The last buffer is full and we cannot store any more data, stop here
+			break;
 		}
-		const size_t copyLength = min<size_t>(len - copied, OUTPUT_BUFFER_SIZE - last->dataLength);
+		const size_t copyLength = min<size_t>(len - copied, last->capacity - last->dataLength);
 		memcpy(last->data + last->dataLength, src + copied, copyLength);
 		last->dataLength += copyLength;
 		copied += copyLength;
@@ -354,28 +345,64 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 /*static*/ void OutputBuffer::Init() noexcept
 {
 	freeOutputBuffers = nullptr;
+	char * const storage = new char[OUTPUT_BUFFER_COUNT * OUTPUT_BUFFER_SIZE];
 	for (size_t i = 0; i < OUTPUT_BUFFER_COUNT; i++)
 	{
-		freeOutputBuffers = new OutputBuffer(freeOutputBuffers);
+		freeOutputBuffers = new OutputBuffer(freeOutputBuffers, storage + i * OUTPUT_BUFFER_SIZE, OUTPUT_BUFFER_SIZE);
+	}
+
+	freeLargeOutputBuffers = nullptr;
+	if (OUTPUT_LARGE_BUFFER_COUNT != 0)
+	{
+		char * const largeStorage = new char[OUTPUT_LARGE_BUFFER_COUNT * OUTPUT_LARGE_BUFFER_SIZE];
+		for (size_t i = 0; i < OUTPUT_LARGE_BUFFER_COUNT; i++)
+		{
+			freeLargeOutputBuffers = new OutputBuffer(freeLargeOutputBuffers, largeStorage + i * OUTPUT_LARGE_BUFFER_SIZE, OUTPUT_LARGE_BUFFER_SIZE);
+		}
 	}
 }
 
 // Allocates an output buffer instance which can be used for (large) string outputs. This must be thread safe. Not safe to call from interrupts!
-/*static*/ bool OutputBuffer::Allocate(OutputBuffer *&buf) noexcept
+// If preferLarge is true then we try to allocate a large buffer first, else we try to allocate a small one first.
+/*static*/ bool OutputBuffer::Allocate(OutputBuffer *&buf, bool preferLarge) noexcept
 {
 	{
 		TaskCriticalSectionLocker lock;
 
-		buf = freeOutputBuffers;
-		if (buf != nullptr)
+		if (preferLarge || freeOutputBuffers == nullptr)
+		{
+			buf = freeLargeOutputBuffers;
+			if (buf != nullptr)
+			{
+				freeLargeOutputBuffers = buf->next;
+				usedLargeOutputBuffers++;
+				if (usedLargeOutputBuffers > maxUsedLargeOutputBuffers)
+				{
+					maxUsedLargeOutputBuffers = usedLargeOutputBuffers;
+				}
+			}
+		}
+		else
 		{
-			freeOutputBuffers = buf->next;
-			usedOutputBuffers++;
-			if (usedOutputBuffers > maxUsedOutputBuffers)
+			buf = nullptr;
+		}
+
+		if (buf == nullptr)
+		{
+			buf = freeOutputBuffers;
+			if (buf != nullptr)
 			{
-				maxUsedOutputBuffers = usedOutputBuffers;
+				freeOutputBuffers = buf->next;
+				usedOutputBuffers++;
+				if (usedOutputBuffers > maxUsedOutputBuffers)
+				{
+					maxUsedOutputBuffers = usedOutputBuffers;
+				}
 			}
+		}
 
+		if (buf != nullptr)
+		{
 			// Initialise the buffer before we release the lock in case another task uses it immediately
 			buf->next = nullptr;
 			buf->last = buf;
@@ -397,7 +424,8 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 /*static*/ size_t OutputBuffer::GetBytesLeft(const OutputBuffer *writingBuffer) noexcept
 {
 	const size_t freeBuffers = OUTPUT_BUFFER_COUNT - usedOutputBuffers;
-	const size_t bytesLeft = OUTPUT_BUFFER_SIZE - writingBuffer->last->DataLength();
+	const size_t bytesLeft = writingBuffer->last->capacity - writingBuffer->last->DataLength()
+								+ (OUTPUT_LARGE_BUFFER_COUNT - usedLargeOutputBuffers) * OUTPUT_LARGE_BUFFER_SIZE;
 
 	if (freeBuffers < RESERVED_OUTPUT_BUFFERS)
 	{
@@ -433,8 +461,8 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 		}
 
 		// Unlink and free the last entry
+		releasedBytes += lastItem->capacity;
 		ReleaseAll(previousItem->next);
-		releasedBytes += OUTPUT_BUFFER_SIZE;
 	} while (previousItem != buffer && releasedBytes < bytesNeeded);
 
 	// Update all the references to the last item
@@ -457,13 +485,19 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 		buf->references--;
 		buf->bytesRead = 0;
 	}
-	else
+	else if (buf->capacity == OUTPUT_BUFFER_SIZE)
 	{
 		// Otherwise prepend it to the list of free output buffers again
 		buf->next = freeOutputBuffers;
 		freeOutputBuffers = buf;
 		usedOutputBuffers--;
 	}
+	else
+	{
+		buf->next = freeLargeOutputBuffers;
+		freeLargeOutputBuffers = buf;
+		usedLargeOutputBuffers--;
+	}
 	return nextBuffer;
 }
 
@@ -477,8 +511,8 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 
 /*static*/ void OutputBuffer::Diagnostics(MessageType mtype) noexcept
 {
-	reprap.GetPlatform().MessageF(mtype, "Used output buffers: %d of %d (%d max)\n",
-			usedOutputBuffers, OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers);
+	reprap.GetPlatform().MessageF(mtype, "Used output buffers: %d of %d (%d max), large %d of %d (%d max)\n",
+			usedOutputBuffers, OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers, usedLargeOutputBuffers, OUTPUT_LARGE_BUFFER_COUNT, maxUsedLargeOutputBuffers);
 }
 
 //*************************************************************************************************
@@ -21,7 +21,7 @@ const size_t OUTPUT_STACK_DEPTH = 4;	// Number of OutputBuffer chains that can b
 class OutputBuffer
 {
 public:
-	explicit OutputBuffer(OutputBuffer *null n) noexcept : next(n) { }
+	OutputBuffer(OutputBuffer *null n, char *_ecv_array storage, size_t size) noexcept : next(n), data(storage), capacity(size) { }
 	OutputBuffer(const OutputBuffer&) = delete;
 
 	void Append(OutputBuffer *other) noexcept;
@@ -33,6 +33,7 @@ public:
 	const char *_ecv_array Data() const noexcept { return data; }
 	const char *_ecv_array UnreadData() const noexcept { return data + bytesRead; }
 	size_t DataLength() const noexcept { return dataLength; }	// How many bytes have been written to this instance?
+	size_t Capacity() const noexcept { return capacity; }		// How many bytes can this instance hold?
 	size_t Length() const noexcept;								// How many bytes have been written to the whole chain?
 
 	char& operator[](size_t index) noexcept;
@@ -74,7 +75,8 @@ public:
 	static void Init() noexcept;
 
 	// Allocate an unused OutputBuffer instance. Returns true on success or false if no instance could be allocated.
-	static bool Allocate(OutputBuffer *&buf) noexcept;
+	// Large buffers are only used for new responses when there are no small ones left.
+	static bool Allocate(OutputBuffer *&buf) noexcept { return Allocate(buf, false); }
 
 	// Get the number of bytes left for allocation. If writingBuffer is not NULL, this returns the number of free bytes for
 	// continuous writes, i.e. for writes that need to allocate an extra OutputBuffer instance to finish the message.
@@ -93,15 +95,23 @@ public:
 
 	static unsigned int GetFreeBuffers() noexcept { return OUTPUT_BUFFER_COUNT - usedOutputBuffers; }
 
+	// The amount of output buffer space that a long response such as an object model report may use
+	static constexpr size_t LongResponseSpace = (OUTPUT_BUFFER_SIZE * (OUTPUT_BUFFER_COUNT - RESERVED_OUTPUT_BUFFERS) + OUTPUT_LARGE_BUFFER_SIZE * OUTPUT_LARGE_BUFFER_COUNT)/2;
+
 private:
 	void Clear() noexcept;
+	bool Extend() noexcept;
+
+	// Allocate a buffer, preferring a large one if 'preferLarge' is true. This is used to extend responses that don't fit in one buffer.
+	static bool Allocate(OutputBuffer *&buf, bool preferLarge) noexcept;
 
 	OutputBuffer *null next;
 	OutputBuffer *last;
 
 	uint32_t whenQueued;									// milliseconds timer when this buffer was filled in
 
-	char data[OUTPUT_BUFFER_SIZE];
+	char *_ecv_array const data;
+	const size_t capacity;
 	size_t dataLength, bytesRead;
 
 	bool isReferenced;
@@ -111,6 +121,10 @@ private:
 	static OutputBuffer * volatile freeOutputBuffers;		// Messages may be sent by multiple tasks
 	static volatile size_t usedOutputBuffers;				// so make these volatile.
 	static volatile size_t maxUsedOutputBuffers;
+
+	static OutputBuffer * volatile freeLargeOutputBuffers;
+	static volatile size_t usedLargeOutputBuffers;
+	static volatile size_t maxUsedLargeOutputBuffers;
 };
 
 inline uint32_t OutputBuffer::GetAge() const noexcept
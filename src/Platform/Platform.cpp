@@ -43,6 +43,7 @@
 #include <Hardware/I2C.h>
 #include <Hardware/NonVolatileMemory.h>
 #include <Storage/CRC32.h>
+#include <GCodes/GCodeBuffer/CompiledExpression.h>
 #include <Accelerometers/Accelerometers.h>
 
 #if SAM4E || SAM4S || SAME70
@@ -2299,25 +2300,45 @@ GCodeResult Platform::DiagnosticTest(GCodeBuffer& gb, const StringRef& reply, Ou
 
 	case (unsigned int)DiagnosticTestType::TimeCRC32:
 		{
+			// Time each CRC implementation that is available on this processor and check that they agree
 			const size_t length = (gb.Seen('S')) ? gb.GetUIValue() : 1024;
-			CRC32 crc;
-			IrqDisable();
-			asm volatile("":::"memory");
-			uint32_t now1 = SysTick->VAL;
-			crc.Update(
 #if SAME5x
-						reinterpret_cast<const char *_ecv_array>(HSRAM_ADDR),
+			const char *_ecv_array const data = reinterpret_cast<const char *_ecv_array>(HSRAM_ADDR);
 #else
-						reinterpret_cast<const char *_ecv_array>(IRAM_ADDR),		// for the SAME70 this is in the non-cacheable RAM, which is the usual case when computing a CRC
+			const char *_ecv_array const data = reinterpret_cast<const char *_ecv_array>(IRAM_ADDR);		// for the SAME70 this is in the non-cacheable RAM, which is the usual case when computing a CRC
 #endif
-						length);
-			uint32_t now2 = SysTick->VAL;
-			asm volatile("":::"memory");
-			IrqEnable();
-			now1 &= 0x00FFFFFF;
-			now2 &= 0x00FFFFFF;
-			uint32_t tim1 = ((now1 > now2) ? now1 : now1 + (SysTick->LOAD & 0x00FFFFFF) + 1) - now2;
-			reply.printf("CRC of %u bytes took %.2fus", length, (double)((1'000'000.0f * (float)tim1)/(float)SystemCoreClock));
+			reply.printf("CRC of %u bytes:", length);
+			uint32_t firstCrc = 0;
+			bool mismatch = false;
+			for (unsigned int i = 0; i < CRC32::NumImplementations; ++i)
+			{
+				CRC32 crc;
+				IrqDisable();
+				asm volatile("":::"memory");
+				uint32_t now1 = SysTick->VAL;
+				crc.UpdateUsing(i, data, length);
+				uint32_t now2 = SysTick->VAL;
+				asm volatile("":::"memory");
+				IrqEnable();
+				now1 &= 0x00FFFFFF;
+				now2 &= 0x00FFFFFF;
+				uint32_t tim1 = ((now1 > now2) ? now1 : now1 + (SysTick->LOAD & 0x00FFFFFF) + 1) - now2;
+				const float microseconds = (1'000'000.0f * (float)tim1)/(float)SystemCoreClock;
+				reply.catf(" %s %.2fus (%.1fMbytes/sec)", CRC32::GetImplementationName(i), (double)microseconds, (double)((float)length/max<float>(microseconds, 0.01)));
+				if (i == 0)
+				{
+					firstCrc = crc.Get();
+				}
+				else if (crc.Get() != firstCrc)
+				{
+					mismatch = true;
+				}
+			}
+			if (mismatch)
+			{
+				reply.cat(", results differ");
+				return GCodeResult::error;
+			}
 		}
 		break;
 
@@ -2367,6 +2388,38 @@ GCodeResult Platform::DiagnosticTest(GCodeBuffer& gb, const StringRef& reply, Ou
 #endif
 		break;
 
+	case (unsigned int)DiagnosticTestType::TimeStepCalculations:	// Caution: may disable interrupts for several hundred microseconds
+		DriveMovement::TimeStepCalculations(reply);
+		break;
+
+	case (unsigned int)DiagnosticTestType::TimeKinematics:
+		reprap.GetMove().TimeKinematics(reply);
+		break;
+
+	case (unsigned int)DiagnosticTestType::TimeHeightMap:
+		reprap.GetMove().AccessHeightMap().TimeInterpolation(reply);
+		break;
+
+	case (unsigned int)DiagnosticTestType::TimeParsing:
+		gb.TimeParsing(reply);
+		break;
+
+#if SUPPORT_OBJECT_MODEL
+	case (unsigned int)DiagnosticTestType::TimeModelResponses:
+		reprap.TimeModelResponses(reply);
+		break;
+#endif
+
+#if SUPPORT_COMPILED_EXPRESSIONS
+	case (unsigned int)DiagnosticTestType::TimeExpressions:
+		CompiledExpression::TimeEvaluation(gb, reply);
+		break;
+#endif
+
+	case (unsigned int)DiagnosticTestType::TimeVariableLookup:
+		VariableSet::TimeLookups(reply);
+		break;
+
 #if HAS_VOLTAGE_MONITOR
 	case (unsigned int)DiagnosticTestType::UndervoltageEvent:
 		reprap.GetGCodes().LowVoltagePause();
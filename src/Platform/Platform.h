@@ -177,9 +177,16 @@ enum class DiagnosticTestType : unsigned int
 	TimeSDWrite = 104,				// do a write timing test on the SD card
 	PrintObjectSizes = 105,			// print the sizes of various objects
 	PrintObjectAddresses = 106,		// print the addresses and sizes of various objects
-	TimeCRC32 = 107,				// time how long it takes to calculate CRC32
+	TimeCRC32 = 107,				// time how long it takes to calculate CRC32 using each implementation available
 	TimeGetTimerTicks = 108,		// time now long it takes to read the step clock
 	UndervoltageEvent = 109,		// pretend an undervoltage condition has occurred
+	TimeStepCalculations = 110,		// time the step time calculations singly and in blocks
+	TimeKinematics = 111,			// time the coordinate conversions of the current kinematics
+	TimeHeightMap = 112,			// time the mesh bed compensation height error interpolation
+	TimeParsing = 113,				// time finding and looking up the parameters of this command
+	TimeModelResponses = 114,		// time full and changes-only object model responses
+	TimeExpressions = 115,			// time compiled and parsed evaluation of an expression
+	TimeVariableLookup = 116,		// time looking up variables in sets of 8 and 32 variables
 
 #ifdef __LPC17xx__
 	PrintBoardConfiguration = 200,	// Prints out all pin/values loaded from SDCard to configure board
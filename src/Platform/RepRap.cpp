@@ -22,6 +22,7 @@
 #include <Hardware/SoftwareReset.h>
 #include <Hardware/ExceptionHandlers.h>
 #include <Accelerometers/Accelerometers.h>
+#include <Storage/DirectoryCache.h>
 #include "Version.h"
 
 #ifdef DUET_NG
@@ -330,6 +331,7 @@ constexpr ObjectModelTableEntry RepRap::objectModelTable[] =
 	{ "deferredPowerDown",		OBJECT_MODEL_FUNC_IF(self->platform->IsAtxPowerControlled(), self->platform->IsDeferredPowerDown()),	ObjectModelEntryFlags::none },
 	{ "displayMessage",			OBJECT_MODEL_FUNC(self->message.c_str()),								ObjectModelEntryFlags::none },
 	{ "gpOut",					OBJECT_MODEL_FUNC_NOSELF(&gpoutArrayDescriptor),						ObjectModelEntryFlags::live },
+	{ "heap",					OBJECT_MODEL_FUNC(self, 7),												ObjectModelEntryFlags::verbose },
 #if SUPPORT_LASER
 	// 2020-04-24: return the configured laser PWM even if the laser is temporarily turned off
 	{ "laserPwm",				OBJECT_MODEL_FUNC_IF(self->gCodes->GetMachineType() == MachineType::laser, self->gCodes->GetLaserPwm(), 2),	ObjectModelEntryFlags::live },
@@ -395,11 +397,18 @@ constexpr ObjectModelTableEntry RepRap::objectModelTable[] =
 	{ "volChanges",				OBJECT_MODEL_FUNC_NOSELF(&volChangesArrayDescriptor),					ObjectModelEntryFlags::live },
 	{ "volumes",				OBJECT_MODEL_FUNC((int32_t)self->volumesSeq),							ObjectModelEntryFlags::live },
 #endif
+
+	// 7. MachineModel.state.heap
+	{ "allocated",				OBJECT_MODEL_FUNC_NOSELF((int32_t)StringHandle::GetHeapSpace()),			ObjectModelEntryFlags::verbose },
+	{ "fragmentation",			OBJECT_MODEL_FUNC_NOSELF(StringHandle::GetFragmentation(), 1),			ObjectModelEntryFlags::verbose },
+	{ "gcCycles",				OBJECT_MODEL_FUNC_NOSELF((int32_t)StringHandle::GetGcCycles()),			ObjectModelEntryFlags::verbose },
+	{ "maxGcPause",				OBJECT_MODEL_FUNC_NOSELF((int32_t)StringHandle::GetMaxGcPauseMicroseconds()),	ObjectModelEntryFlags::verbose },
+	{ "used",					OBJECT_MODEL_FUNC_NOSELF((int32_t)StringHandle::GetHeapUsed()),			ObjectModelEntryFlags::verbose },
 };
 
 constexpr uint8_t RepRap::objectModelTableDescriptor[] =
 {
-	7,																						// number of sub-tables
+	8,																						// number of sub-tables
 	15 + SUPPORT_SCANNER + (HAS_MASS_STORAGE | HAS_EMBEDDED_FILES | HAS_SBC_INTERFACE),		// root
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
 	8, 																						// directories
@@ -407,11 +416,12 @@ constexpr uint8_t RepRap::objectModelTableDescriptor[] =
 	0,																						// directories
 #endif
 	25,																						// limits
-	20 + HAS_VOLTAGE_MONITOR + SUPPORT_LASER,												// state
+	21 + HAS_VOLTAGE_MONITOR + SUPPORT_LASER,												// state
 	2,																						// state.beep
 	6,																						// state.messageBox
 	12 + HAS_NETWORKING + SUPPORT_SCANNER +
-	2 * HAS_MASS_STORAGE + (HAS_MASS_STORAGE | HAS_EMBEDDED_FILES | HAS_SBC_INTERFACE)		// seqs
+	2 * HAS_MASS_STORAGE + (HAS_MASS_STORAGE | HAS_EMBEDDED_FILES | HAS_SBC_INTERFACE),		// seqs
+	5,																						// state.heap
 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(RepRap)
@@ -427,6 +437,7 @@ ReadWriteLock RepRap::toolListLock;
 RepRap::RepRap() noexcept
 	: boardsSeq(0), directoriesSeq(0), fansSeq(0), heatSeq(0), inputsSeq(0), jobSeq(0), moveSeq(0), globalSeq(0),
 	  networkSeq(0), scannerSeq(0), sensorsSeq(0), spindlesSeq(0), stateSeq(0), toolsSeq(0), volumesSeq(0),
+	  modelGeneration(1), seqChangeGenerations{},
 	  toolList(nullptr), currentTool(nullptr), lastWarningMillis(0),
 	  activeExtruders(0), activeToolHeaters(0), numToolsToReport(0),
 	  ticksInSpinState(0), heatTaskIdleTicks(0),
@@ -785,6 +796,9 @@ void RepRap::Spin() noexcept
 	ticksInSpinState = 0;
 	spinningModule = noModule;
 
+	// Do some incremental garbage collection of the string heap if it is worthwhile
+	StringHandle::Spin();
+
 	// Check if we need to send diagnostics
 	if (diagnosticsDestination != MessageType::NoDestinationMessage)
 	{
@@ -2121,38 +2135,49 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, unsigned int startAt, bo
 	else
 	{
 		err = 0;
-		FileInfo fileInfo;
-		unsigned int filesFound = 0;
-		bool gotFile = MassStorage::FindFirst(dir, fileInfo);
-
 		size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
 
-		while (gotFile)
+		// Append a file to the response, returning false if there is no room for it
+		auto appendFile = [response, &bytesLeft, &nextFile, startAt, flagsDirs](unsigned int index, const FileInfo& fileInfo) noexcept -> bool
 		{
-			if (fileInfo.fileName[0] != '.')						// ignore Mac resource files and Linux hidden files
+			// Make sure we can end this response properly
+			if (bytesLeft < fileInfo.fileName.strlen() * 2 + 20)
+			{
+				// No more space available - stop here
+				nextFile = index;
+				return false;
+			}
+
+			// Write separator and filename
+			if (index != startAt)
 			{
-				if (filesFound >= startAt)
+				bytesLeft -= response->cat(',');
+			}
+
+			bytesLeft -= response->catf((flagsDirs && fileInfo.isDirectory) ? "\"*%.s\"" : "\"%.s\"", fileInfo.fileName.c_str());
+			return true;
+		};
+
+#if SUPPORT_DIRECTORY_CACHE
+		if (!DirectoryCache::IterateWhile(dir, startAt, appendFile))
+#endif
+		{
+			FileInfo fileInfo;
+			unsigned int filesFound = 0;
+			bool gotFile = MassStorage::FindFirst(dir, fileInfo);
+			while (gotFile)
+			{
+				if (fileInfo.fileName[0] != '.')					// ignore Mac resource files and Linux hidden files
 				{
-					// Make sure we can end this response properly
-					if (bytesLeft < fileInfo.fileName.strlen() * 2 + 20)
+					if (filesFound >= startAt && !appendFile(filesFound, fileInfo))
 					{
-						// No more space available - stop here
 						MassStorage::AbandonFindNext();
-						nextFile = filesFound;
 						break;
 					}
-
-					// Write separator and filename
-					if (filesFound != startAt)
-					{
-						bytesLeft -= response->cat(',');
-					}
-
-					bytesLeft -= response->catf((flagsDirs && fileInfo.isDirectory) ? "\"*%.s\"" : "\"%.s\"", fileInfo.fileName.c_str());
+					++filesFound;
 				}
-				++filesFound;
+				gotFile = MassStorage::FindNext(fileInfo);
 			}
-			gotFile = MassStorage::FindNext(fileInfo);
 		}
 	}
 
@@ -2200,51 +2225,63 @@ OutputBuffer *RepRap::GetFilelistResponse(const char *dir, unsigned int startAt)
 	else
 	{
 		err = 0;
-		FileInfo fileInfo;
-		unsigned int filesFound = 0;
-		bool gotFile = MassStorage::FindFirst(dir, fileInfo);
 		size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
 
-		while (gotFile)
+		// Append a file entry to the response, returning false if there is no room for it
+		auto appendFile = [response, &bytesLeft, &nextFile, startAt](unsigned int index, const FileInfo& fileInfo) noexcept -> bool
 		{
-			if (fileInfo.fileName[0] != '.')			// ignore Mac resource files and Linux hidden files
+			// Make sure we can end this response properly
+			if (bytesLeft < fileInfo.fileName.strlen() * 2 + 50)
 			{
-				if (filesFound >= startAt)
+				// No more space available - stop here
+				nextFile = index;
+				return false;
+			}
+
+			// Write delimiter
+			if (index != startAt)
+			{
+				bytesLeft -= response->cat(',');
+			}
+
+			// Write another file entry
+			bytesLeft -= response->catf("{\"type\":\"%c\",\"name\":\"%.s\",\"size\":%" PRIu32,
+										fileInfo.isDirectory ? 'd' : 'f', fileInfo.fileName.c_str(), fileInfo.size);
+			tm timeInfo;
+			gmtime_r(&fileInfo.lastModified, &timeInfo);
+			if (timeInfo.tm_year <= /*19*/80)
+			{
+				// Don't send the last modified date if it is invalid
+				bytesLeft -= response->cat('}');
+			}
+			else
+			{
+				bytesLeft -= response->catf(",\"date\":\"%04u-%02u-%02uT%02u:%02u:%02u\"}",
+						timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
+			}
+			return true;
+		};
+
+#if SUPPORT_DIRECTORY_CACHE
+		if (!DirectoryCache::IterateWhile(dir, startAt, appendFile))
+#endif
+		{
+			FileInfo fileInfo;
+			unsigned int filesFound = 0;
+			bool gotFile = MassStorage::FindFirst(dir, fileInfo);
+			while (gotFile)
+			{
+				if (fileInfo.fileName[0] != '.')					// ignore Mac resource files and Linux hidden files
 				{
-					// Make sure we can end this response properly
-					if (bytesLeft < fileInfo.fileName.strlen() * 2 + 50)
+					if (filesFound >= startAt && !appendFile(filesFound, fileInfo))
 					{
-						// No more space available - stop here
 						MassStorage::AbandonFindNext();
-						nextFile = filesFound;
 						break;
 					}
-
-					// Write delimiter
-					if (filesFound != startAt)
-					{
-						bytesLeft -= response->cat(',');
-					}
-
-					// Write another file entry
-					bytesLeft -= response->catf("{\"type\":\"%c\",\"name\":\"%.s\",\"size\":%" PRIu32,
-												fileInfo.isDirectory ? 'd' : 'f', fileInfo.fileName.c_str(), fileInfo.size);
-					tm timeInfo;
-					gmtime_r(&fileInfo.lastModified, &timeInfo);
-					if (timeInfo.tm_year <= /*19*/80)
-					{
-						// Don't send the last modified date if it is invalid
-						bytesLeft -= response->cat('}');
-					}
-					else
-					{
-						bytesLeft -= response->catf(",\"date\":\"%04u-%02u-%02uT%02u:%02u:%02u\"}",
-								timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
-					}
+					++filesFound;
 				}
-				++filesFound;
+				gotFile = MassStorage::FindNext(fileInfo);
 			}
-			gotFile = MassStorage::FindNext(fileInfo);
 		}
 	}
 
@@ -2536,8 +2573,63 @@ void RepRap::AppendStringArray(OutputBuffer *buf, const char *name, size_t numVa
 
 #if SUPPORT_OBJECT_MODEL
 
+// Names of the top-level object model keys that have a seqs counter, in the same order as enum ModelSeq
+static constexpr const char *_ecv_array modelSeqNames[] =
+{
+	"boards", "directories", "fans", "global", "heat", "inputs", "job", "move", "network", "scanner", "sensors", "spindles", "state", "tools", "volumes"
+};
+
+// Return the model generation at which the top-level key was last changed.
+// Keys that have no seqs counter might have changed at any time, so for them we return the largest possible generation.
+uint32_t RepRap::GetKeyChangeGeneration(const char *_ecv_array key) const noexcept
+{
+	static_assert(ARRAY_SIZE(modelSeqNames) == (size_t)ModelSeq::numSeqs);
+	for (size_t i = 0; i < ARRAY_SIZE(modelSeqNames); ++i)
+	{
+		if (strcmp(key, modelSeqNames[i]) == 0)
+		{
+			return seqChangeGenerations[i];
+		}
+	}
+	return UINT32_MAX;
+}
+
+// Report the whole object model, but report only the live values of top-level keys whose seqs counter has not changed since the specified generation.
+// Keys that have no live values and have not changed are omitted. Keys that have no seqs counter are always reported in full. If the generation is 0 or is one we haven't reached yet (e.g. we have been reset) then everything is reported.
+void RepRap::ReportChangesAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array flags, uint32_t sinceGeneration) const THROWS(GCodeException)
+{
+	// Changed keys are reported in full even if the client asked for live values only, so remove any 'f' flag; then make a copy with it added for the unchanged keys
+	String<StringLength20> fullFlags;
+	for (const char *_ecv_array p = flags; *p != 0; ++p)
+	{
+		if (*p != 'f')
+		{
+			fullFlags.cat(*p);
+		}
+	}
+	String<StringLength20> liveFlags;
+	liveFlags.copy(fullFlags.c_str());
+	liveFlags.cat('f');
+
+	const bool reportAll = (sinceGeneration == 0 || sinceGeneration > modelGeneration);
+	bool first = true;
+	for (size_t i = 0; i < objectModelTableDescriptor[1]; ++i)
+	{
+		const ObjectModelTableEntry& entry = objectModelTable[i];
+		const bool changed = reportAll || GetKeyChangeGeneration(entry.name) > sinceGeneration;
+		if (changed || ((uint8_t)entry.flags & (uint8_t)ObjectModelEntryFlags::live) != 0)
+		{
+			buf->catf((first) ? "{\"%s\":" : ",\"%s\":", entry.name);
+			ReportAsJson(gb, buf, entry.name, (changed) ? fullFlags.c_str() : liveFlags.c_str(), false);
+			first = false;
+		}
+	}
+	buf->cat((first) ? "{}" : "}");
+}
+
 // Return a query into the object model, or return nullptr if no buffer available
 // We append a newline to help PanelDue resync after receiving corrupt or incomplete data. DWC ignores it.
+// If the key is empty and the flags include 'c' followed by the "gen" value from a previous response, only the changes since that response are reported in full.
 OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException)
 {
 	OutputBuffer *outBuf;
@@ -2554,9 +2646,20 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 			++key;
 		}
 
+		const char *_ecv_array const changesFlag = (*key == 0 && !wantArrayLength) ? strchr(flags, 'c') : nullptr;
+		const uint32_t currentGeneration = modelGeneration;				// read this before reporting so that we don't miss changes made while we report
+
 		try
 		{
-			reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength);
+			if (changesFlag != nullptr)
+			{
+				ReportChangesAsJson(gb, outBuf, flags, StrToU32(changesFlag + 1));
+				outBuf->catf(",\"gen\":%" PRIu32, currentGeneration);
+			}
+			else
+			{
+				reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength);
+			}
 			outBuf->cat("}\n");
 			if (outBuf->HadOverflow())
 			{
@@ -2573,6 +2676,46 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 	return outBuf;
 }
 
+// Time the generation of a full response and of a changes-only response when nothing has changed
+void RepRap::TimeModelResponses(const StringRef& reply) const noexcept
+{
+	const char *const testFlags[2] = { "d99n", "d99nc" };
+	size_t responseBytes[2] = { 0, 0 };
+	uint32_t responseTicks[2] = { 0, 0 };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		String<StringLength20> flags;
+		flags.copy(testFlags[i]);
+		if (i != 0)
+		{
+			flags.catf("%" PRIu32, modelGeneration.load());
+		}
+
+		const uint32_t startTicks = StepTimer::GetTimerTicks();
+		OutputBuffer *_ecv_null outBuf;
+		try
+		{
+			outBuf = GetModelResponse(nullptr, "", flags.c_str());
+		}
+		catch (const GCodeException&)
+		{
+			outBuf = nullptr;
+		}
+		responseTicks[i] = StepTimer::GetTimerTicks() - startTicks;
+		if (outBuf == nullptr)
+		{
+			reply.copy("Failed to generate response");
+			return;
+		}
+		responseBytes[i] = outBuf->Length();
+		OutputBuffer::ReleaseAll(outBuf);
+	}
+
+	reply.printf("Full response %u bytes in %.0fus, changes-only response %u bytes in %.0fus",
+					responseBytes[0], (double)((float)responseTicks[0] * StepClocksToMillis * 1000.0),
+					responseBytes[1], (double)((float)responseTicks[1] * StepClocksToMillis * 1000.0));
+}
+
 #endif
 
 // Send a beep. We send it to both PanelDue and the web interface.
@@ -26,6 +26,7 @@ Licence: GPL
 #include <RTOSIface/RTOSIface.h>
 #include <General/function_ref.h>
 #include <ObjectModel/GlobalVariables.h>
+#include <atomic>
 
 #if SUPPORT_CAN_EXPANSION
 # include <CAN/ExpansionManager.h>
@@ -155,6 +156,7 @@ public:
 
 #if SUPPORT_OBJECT_MODEL
 	OutputBuffer *GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException);
+	void TimeModelResponses(const StringRef& reply) const noexcept;		// time full and changes-only object model responses
 #endif
 
 	void Beep(unsigned int freq, unsigned int ms) noexcept;
@@ -184,21 +186,21 @@ public:
 
 	void KickHeatTaskWatchdog() noexcept { heatTaskIdleTicks = 0; }
 
-	void BoardsUpdated() noexcept { ++boardsSeq; }
-	void DirectoriesUpdated() noexcept { ++directoriesSeq; }
-	void FansUpdated() noexcept { ++fansSeq; }
-	void GlobalUpdated() noexcept { ++globalSeq; }
-	void HeatUpdated() noexcept { ++heatSeq; }
-	void InputsUpdated() noexcept { ++inputsSeq; }
-	void JobUpdated() noexcept { ++jobSeq; }
-	void MoveUpdated() noexcept { ++moveSeq; }
-	void NetworkUpdated() noexcept { ++networkSeq; }
-	void ScannerUpdated() noexcept { ++scannerSeq; }
-	void SensorsUpdated() noexcept { ++sensorsSeq; }
-	void SpindlesUpdated() noexcept { ++spindlesSeq; }
-	void StateUpdated() noexcept { ++stateSeq; }
-	void ToolsUpdated() noexcept { ++toolsSeq; }
-	void VolumesUpdated() noexcept { ++volumesSeq; }
+	void BoardsUpdated() noexcept { ++boardsSeq; SeqChanged(ModelSeq::boards); }
+	void DirectoriesUpdated() noexcept { ++directoriesSeq; SeqChanged(ModelSeq::directories); }
+	void FansUpdated() noexcept { ++fansSeq; SeqChanged(ModelSeq::fans); }
+	void GlobalUpdated() noexcept { ++globalSeq; SeqChanged(ModelSeq::global); }
+	void HeatUpdated() noexcept { ++heatSeq; SeqChanged(ModelSeq::heat); }
+	void InputsUpdated() noexcept { ++inputsSeq; SeqChanged(ModelSeq::inputs); }
+	void JobUpdated() noexcept { ++jobSeq; SeqChanged(ModelSeq::job); }
+	void MoveUpdated() noexcept { ++moveSeq; SeqChanged(ModelSeq::move); }
+	void NetworkUpdated() noexcept { ++networkSeq; SeqChanged(ModelSeq::network); }
+	void ScannerUpdated() noexcept { ++scannerSeq; SeqChanged(ModelSeq::scanner); }
+	void SensorsUpdated() noexcept { ++sensorsSeq; SeqChanged(ModelSeq::sensors); }
+	void SpindlesUpdated() noexcept { ++spindlesSeq; SeqChanged(ModelSeq::spindles); }
+	void StateUpdated() noexcept { ++stateSeq; SeqChanged(ModelSeq::state); }
+	void ToolsUpdated() noexcept { ++toolsSeq; SeqChanged(ModelSeq::tools); }
+	void VolumesUpdated() noexcept { ++volumesSeq; SeqChanged(ModelSeq::volumes); }
 
 	ReadLockedPointer<const VariableSet> GetGlobalVariablesForReading() noexcept { return globalVariables.GetForReading(); }
 	WriteLockedPointer<VariableSet> GetGlobalVariablesForWriting() noexcept { return globalVariables.GetForWriting(); }
@@ -216,6 +218,19 @@ protected:
 	OBJECT_MODEL_ARRAY(volChanges)
 
 private:
+	// Top-level object model keys that have a seqs counter. These must be in the same order as the names in modelSeqNames.
+	enum class ModelSeq : uint8_t
+	{
+		boards = 0, directories, fans, global, heat, inputs, job, move, network, scanner, sensors, spindles, state, tools, volumes,
+		numSeqs
+	};
+
+	void SeqChanged(ModelSeq seq) noexcept { seqChangeGenerations[(size_t)seq] = ++modelGeneration; }
+#if SUPPORT_OBJECT_MODEL
+	uint32_t GetKeyChangeGeneration(const char *_ecv_array key) const noexcept;
+	void ReportChangesAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array flags, uint32_t sinceGeneration) const THROWS(GCodeException);
+#endif
+
 	static void EncodeString(StringRef& response, const char* src, size_t spaceToLeave, bool allowControlChars = false, char prefix = 0) noexcept;
 	static void AppendFloatArray(OutputBuffer *buf, const char *name, size_t numValues, function_ref<float(size_t)> func, unsigned int numDecimalDigits) noexcept;
 	static void AppendIntArray(OutputBuffer *buf, const char *name, size_t numValues, function_ref<int(size_t)> func) noexcept;
@@ -266,6 +281,12 @@ private:
 	uint16_t boardsSeq, directoriesSeq, fansSeq, heatSeq, inputsSeq, jobSeq, moveSeq, globalSeq;
 	uint16_t networkSeq, scannerSeq, sensorsSeq, spindlesSeq, stateSeq, toolsSeq, volumesSeq;
 
+	// Change tracking for object model responses that report only what has changed. Every time a seqs counter is incremented the
+	// model generation is incremented too and recorded against that counter, so that a client need only send back the generation
+	// number from its previous response rather than all of the seqs values it has seen. Seqs are incremented by several tasks, so the generation is atomic.
+	std::atomic<uint32_t> modelGeneration;
+	uint32_t seqChangeGenerations[(size_t)ModelSeq::numSeqs];
+
 	GlobalVariables globalVariables;
 
 	Tool* toolList;								// the tool list is sorted in order of increasing tool number
@@ -12,6 +12,7 @@
 #include "SbcInterface.h"
 
 #include <Storage/CRC32.h>
+#include <Movement/StepTimer.h>
 #include <algorithm>
 
 #if defined(DUET_NG) && defined(USE_SBC)
@@ -402,6 +403,7 @@ alignas(4) __nocache char DataTransfer::txBuffer[SbcTransferBufferSize];
 #endif
 
 DataTransfer::DataTransfer() noexcept : state(InternalTransferState::ExchangingData), lastTransferNumber(0), failedTransfers(0), checksumErrors(0),
+	numTransfers(0), rxBytesTransferred(0), txBytesTransferred(0), statsStartTime(0), transferFinishedTicks(0), maxProcessingTicks(0),
 #if SAME5x
 	rxBuffer(nullptr), txBuffer(nullptr),
 #endif
@@ -512,6 +514,16 @@ void DataTransfer::Diagnostics(MessageType mtype) noexcept
 	reprap.GetPlatform().MessageF(mtype, "Transfer state: %d, failed transfers: %u, checksum errors: %u\n", (int)state, failedTransfers, checksumErrors);
 	reprap.GetPlatform().MessageF(mtype, "RX/TX seq numbers: %d/%d\n", (int)rxHeader.sequenceNumber, (int)txHeader.sequenceNumber);
 	reprap.GetPlatform().MessageF(mtype, "SPI underruns %u, overruns %u\n", spiTxUnderruns, spiRxOverruns);
+
+	const uint32_t now = millis();
+	const float elapsedSeconds = (float)max<uint32_t>(now - statsStartTime, 1) * 0.001;
+	reprap.GetPlatform().MessageF(mtype, "Transfers %.1f/sec, RX %.1fKb/sec, TX %.1fKb/sec, longest processing time %.2fms\n",
+									(double)((float)numTransfers/elapsedSeconds),
+									(double)((float)rxBytesTransferred/(elapsedSeconds * 1024.0)),
+									(double)((float)txBytesTransferred/(elapsedSeconds * 1024.0)),
+									(double)((float)maxProcessingTicks * StepClocksToMillis));
+	numTransfers = rxBytesTransferred = txBytesTransferred = maxProcessingTicks = 0;
+	statsStartTime = now;
 }
 
 const PacketHeader *DataTransfer::ReadPacket() noexcept
@@ -762,6 +774,20 @@ void DataTransfer::RestartTransfer(bool ownRequest) noexcept
 	}
 }
 
+// Prepare to process the data of a transfer that has been completed successfully and update the statistics
+TransferState DataTransfer::TransferFinished() noexcept
+{
+	++numTransfers;
+	rxBytesTransferred += rxHeader.dataLength;
+	txBytesTransferred += txHeader.dataLength;
+	transferFinishedTicks = StepTimer::GetTimerTicks();
+
+	rxPointer = txPointer = 0;
+	packetId = 0;
+	state = InternalTransferState::ProcessingData;
+	return IsConnectionReset() ? TransferState::connectionReset : TransferState::finished;
+}
+
 TransferState DataTransfer::DoTransfer() noexcept
 {
 	if (dataReceived)
@@ -857,10 +883,7 @@ TransferState DataTransfer::DoTransfer() noexcept
 				else
 				{
 					// Everything OK
-					rxPointer = txPointer = 0;
-					packetId = 0;
-					state = InternalTransferState::ProcessingData;
-					return IsConnectionReset() ? TransferState::connectionReset : TransferState::finished;
+					return TransferFinished();
 				}
 			}
 			else if (rxResponse == TransferResponse::BadHeaderChecksum || txResponse == TransferResponse::BadHeaderChecksum)
@@ -907,10 +930,7 @@ TransferState DataTransfer::DoTransfer() noexcept
 			if (rxResponse == TransferResponse::Success && txResponse == TransferResponse::Success)
 			{
 				// Everything OK
-				rxPointer = txPointer = 0;
-				packetId = 0;
-				state = InternalTransferState::ProcessingData;
-				return IsConnectionReset() ? TransferState::connectionReset : TransferState::finished;
+				return TransferFinished();
 			}
 
 			if (rxResponse == TransferResponse::BadDataChecksum || txResponse == TransferResponse::BadDataChecksum)
@@ -973,6 +993,16 @@ TransferState DataTransfer::DoTransfer() noexcept
 
 void DataTransfer::StartNextTransfer() noexcept
 {
+	if (state == InternalTransferState::ProcessingData)
+	{
+		// The SBC has to wait for us while we process the received data and prepare the next transfer, so keep track of how long that takes
+		const uint32_t processingTicks = StepTimer::GetTimerTicks() - transferFinishedTicks;
+		if (processingTicks > maxProcessingTicks)
+		{
+			maxProcessingTicks = processingTicks;
+		}
+	}
+
 	lastTransferNumber = rxHeader.sequenceNumber;
 
 	// Reset RX transfer header
@@ -1016,24 +1046,25 @@ void DataTransfer::ResetConnection(bool fullReset) noexcept
 bool DataTransfer::WriteObjectModel(OutputBuffer *data) noexcept
 {
 	// Try to write the packet header. This packet type cannot deal with truncated messages
-	if (!CanWritePacket(data->Length()))
+	const size_t dataLength = data->Length();
+	if (!CanWritePacket(dataLength))
 	{
 		return false;
 	}
 
 	// Write packet header
-	(void)WritePacketHeader(FirmwareRequest::ObjectModel, sizeof(StringHeader) + data->Length());
+	(void)WritePacketHeader(FirmwareRequest::ObjectModel, sizeof(StringHeader) + dataLength);
 
 	// Write header
 	StringHeader *header = WriteDataHeader<StringHeader>();
-	header->length = data->Length();
+	header->length = dataLength;
 	header->padding = 0;
 
 	// Write data
-	while (data != nullptr)
+	(void)WriteOutputBuffers(data, dataLength);
+	if (data != nullptr)
 	{
-		WriteData(data->UnreadData(), data->BytesLeft());
-		data = OutputBuffer::Release(data);
+		OutputBuffer::ReleaseAll(data);
 	}
 	return true;
 }
@@ -1074,34 +1105,11 @@ bool DataTransfer::WriteCodeReply(MessageType type, OutputBuffer *&response) noe
 	replyHeader->padding = 0;
 
 	// Write code reply
-	size_t bytesWritten = 0;
+	const size_t bytesWritten = WriteOutputBuffers(response, FreeTxSpace());
 	if (response != nullptr)
 	{
-		size_t bytesToCopy;
-		do
-		{
-			bytesToCopy = min<size_t>(FreeTxSpace(), response->BytesLeft());
-			if (bytesToCopy == 0)
-			{
-				break;
-			}
-
-			WriteData(response->UnreadData(), bytesToCopy);
-			bytesWritten += bytesToCopy;
-
-			response->Taken(bytesToCopy);
-			if (response->BytesLeft() == 0)
-			{
-				response = OutputBuffer::Release(response);
-			}
-		}
-		while (response != nullptr);
-
-		if (response != nullptr)
-		{
-			// There is more to come...
-			replyHeader->messageType = (MessageType)(replyHeader->messageType | PushFlag);
-		}
+		// There is more to come...
+		replyHeader->messageType = (MessageType)(replyHeader->messageType | PushFlag);
 	}
 
 	// Finish the packet
@@ -1733,6 +1741,25 @@ void DataTransfer::WriteData(const char *data, size_t length) noexcept
 	txPointer += length;
 }
 
+// Copy up to maxLength bytes from a chain of output buffers straight into the transmit buffer, releasing each buffer once it has been sent.
+// Return the number of bytes written. On return, 'buf' points to the first buffer that still has data to send, or is null if everything was sent.
+size_t DataTransfer::WriteOutputBuffers(OutputBuffer *&buf, size_t maxLength) noexcept
+{
+	size_t bytesWritten = 0;
+	while (buf != nullptr && bytesWritten < maxLength)
+	{
+		const size_t bytesToCopy = min<size_t>(maxLength - bytesWritten, buf->BytesLeft());
+		WriteData(buf->UnreadData(), bytesToCopy);
+		bytesWritten += bytesToCopy;
+		buf->Taken(bytesToCopy);
+		if (buf->BytesLeft() == 0)
+		{
+			buf = OutputBuffer::Release(buf);
+		}
+	}
+	return bytesWritten;
+}
+
 template<typename T> T *DataTransfer::WriteDataHeader() noexcept
 {
 	T *header = reinterpret_cast<T*>(txBuffer + txPointer);
@@ -107,6 +107,12 @@ private:
 	uint16_t lastTransferNumber;
 	unsigned int failedTransfers, checksumErrors;
 
+	// Transfer statistics, reset when the diagnostics are reported
+	uint32_t numTransfers, rxBytesTransferred, txBytesTransferred;
+	uint32_t statsStartTime;								// when we last reset the statistics, in milliseconds
+	uint32_t transferFinishedTicks;							// when the last transfer finished, in step clocks
+	uint32_t maxProcessingTicks;							// longest time between a transfer finishing and the next one being started
+
 	// Transfer buffers
 #if SAME70
 	// SAME70 has a write-back cache, so these must be in non-cached memory because we DMA to/from them.
@@ -140,6 +146,7 @@ private:
 	void ExchangeResponse(uint32_t response) noexcept;
 	void ExchangeData() noexcept;
 	void RestartTransfer(bool ownRequest) noexcept;
+	TransferState TransferFinished() noexcept;
 	uint32_t CalcCRC32(const char *buffer, size_t length) const noexcept;
 
 	template<typename T> const T *ReadDataHeader() noexcept;
@@ -150,6 +157,7 @@ private:
 	bool CanWritePacket(size_t dataLength = 0) const noexcept;
 	PacketHeader *WritePacketHeader(FirmwareRequest request, size_t dataLength = 0, uint16_t resendPacktId = 0) noexcept;
 	void WriteData(const char *data, size_t length) noexcept;
+	size_t WriteOutputBuffers(OutputBuffer *&buf, size_t maxLength) noexcept;
 	template<typename T> T *WriteDataHeader() noexcept;
 
 	size_t AddPadding(size_t length) const noexcept;
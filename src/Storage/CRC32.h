@@ -9,20 +9,60 @@
 # define USE_SAME5x_HARDWARE_CRC	0
 #endif
 
+// The number of bytes that the software CRC processes per round of table lookups: 1 (1K of tables), 4 (4K) or 8 (8K).
+// This may be defined in the build, for example when building on a host to compare the implementations. The slicing algorithms assume little-endian data.
+#ifndef CRC32_SLICING
+# if SAME70
+#  define CRC32_SLICING		8
+# elif SAM4E || (SAME5x && !USE_SAME5x_HARDWARE_CRC)
+#  define CRC32_SLICING		4
+# else
+#  define CRC32_SLICING		1
+# endif
+#endif
+
 // Note: when USE_SAME5x_HARDWARE_CRC is true, the Update methods must not be called from an ISR!
 class CRC32
 {
 private:
+	typedef uint32_t (*UpdateFunction)(uint32_t locCrc, const char *s, const char *end) noexcept;
+
+	struct Implementation
+	{
+		const char *_ecv_array name;
+		UpdateFunction func;
+	};
+
+	// We already optimised the loops in these, and on the SAME5x unrolling them could make us feed data to the CRC unit too fast
+	static uint32_t UpdateBytewise(uint32_t locCrc, const char *s, const char *end) noexcept __attribute__((optimize("no-unroll-loops")));
+#if CRC32_SLICING >= 4
+	static uint32_t UpdateSlicingBy4(uint32_t locCrc, const char *s, const char *end) noexcept __attribute__((optimize("no-unroll-loops")));
+#endif
+#if CRC32_SLICING >= 8
+	static uint32_t UpdateSlicingBy8(uint32_t locCrc, const char *s, const char *end) noexcept __attribute__((optimize("no-unroll-loops")));
+#endif
+#if USE_SAME5x_HARDWARE_CRC
+	static uint32_t UpdateHardware(uint32_t locCrc, const char *s, const char *end) noexcept __attribute__((optimize("no-unroll-loops")));
+#endif
+
 	uint32_t crc;
 
 public:
+	static constexpr unsigned int NumImplementations = 1 + (CRC32_SLICING >= 4) + (CRC32_SLICING >= 8) + USE_SAME5x_HARDWARE_CRC;
+
 	CRC32() noexcept;
 
 	void Update(char c) noexcept;
-	void Update(const char *s, size_t len) noexcept
-		__attribute__((optimize("no-unroll-loops")));	// we already optimised the loops, and on the SAME5x unrolling them could make us feed data to the CRC unit too fast
+	void Update(const char *s, size_t len) noexcept;
 	void Reset(uint32_t initialValue = 0xFFFFFFFF) noexcept;
 	uint32_t Get() const noexcept;
+
+	// Functions used by the CRC timing test to compare the implementations available on this processor
+	static const char *_ecv_array GetImplementationName(unsigned int n) noexcept pre(n < NumImplementations);
+	void UpdateUsing(unsigned int n, const char *s, size_t len) noexcept pre(n < NumImplementations);
+
+private:
+	static const Implementation implementations[NumImplementations];
 };
 
 inline uint32_t CRC32::Get() const noexcept
@@ -0,0 +1,295 @@
+/*
+ * DirectoryCache.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "DirectoryCache.h"
+
+#if SUPPORT_DIRECTORY_CACHE
+
+#include "MassStorage.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Movement/StepTimer.h>
+#include <cctype>
+
+DirectoryCache::Listing DirectoryCache::listings[NumListings];
+alignas(4) char DirectoryCache::pool[MaxCachedBytes];
+Mutex DirectoryCache::cacheMutex;
+size_t DirectoryCache::bytesCached = 0;
+uint32_t DirectoryCache::useCounter = 0;
+volatile uint32_t DirectoryCache::numFilesWritten = 0;
+uint32_t DirectoryCache::numHits = 0;
+uint32_t DirectoryCache::numMisses = 0;
+uint32_t DirectoryCache::numTooLarge = 0;
+uint32_t DirectoryCache::longestLoadTicks = 0;
+
+/*static*/ void DirectoryCache::Init() noexcept
+{
+	static_assert(MaxCachedBytes <= UINT16_MAX + 1, "Name offsets must fit in 16 bits");
+	cacheMutex.Create("DirCache");
+}
+
+// Discard a listing
+/*static*/ void DirectoryCache::Free(Listing& listing) noexcept
+{
+	bytesCached -= listing.BlockSize();
+	listing.entries = nullptr;
+	listing.names = nullptr;
+	listing.numEntries = listing.namesLength = 0;
+	listing.path.Clear();
+}
+
+// Look for an up-to-date listing of the directory, freeing any listings that are out of date. The cache mutex must be owned.
+/*static*/ DirectoryCache::Listing *_ecv_null DirectoryCache::Find(const char *_ecv_array directory, unsigned int volume) noexcept
+{
+	Listing *_ecv_null found = nullptr;
+	for (Listing& l : listings)
+	{
+		if (!l.IsFree())
+		{
+			if (l.seq != MassStorage::GetVolumeSeq(l.volume) || l.filesWritten != numFilesWritten)
+			{
+				Free(l);
+			}
+			else if (l.volume == volume && StringEqualsIgnoreCase(directory, l.path.c_str()))
+			{
+				found = &l;
+			}
+		}
+	}
+	return found;
+}
+
+// Move the listings to the start of the pool so that all the free space is at the end. The cache mutex must be owned.
+/*static*/ void DirectoryCache::Compact() noexcept
+{
+	char *_ecv_array nextFree = pool;
+	for (;;)
+	{
+		// Find the listing with the lowest address that hasn't been moved yet
+		Listing *_ecv_null lowest = nullptr;
+		for (Listing& l : listings)
+		{
+			if (!l.IsFree() && l.Block() >= nextFree && (lowest == nullptr || l.Block() < lowest->Block()))
+			{
+				lowest = &l;
+			}
+		}
+		if (lowest == nullptr)
+		{
+			break;
+		}
+
+		const size_t blockSize = lowest->BlockSize();
+		if (lowest->Block() != nextFree)
+		{
+			memmove(nextFree, lowest->Block(), blockSize);
+			lowest->entries = reinterpret_cast<Entry *_ecv_array>(nextFree);
+			lowest->names = nextFree + lowest->numEntries * sizeof(Entry);
+		}
+		nextFree += blockSize;
+	}
+}
+
+// Allocate space in the pool after the last listing, moving the listings together first if necessary.
+// The caller must have made sure that there is enough free space in total. The cache mutex must be owned.
+/*static*/ char *_ecv_array DirectoryCache::AllocateBlock(size_t blockSize) noexcept
+{
+	for (unsigned int attempt = 0; ; ++attempt)
+	{
+		char *_ecv_array end = pool;
+		for (const Listing& l : listings)
+		{
+			if (!l.IsFree() && l.Block() + l.BlockSize() > end)
+			{
+				end = l.Block() + l.BlockSize();
+			}
+		}
+		if (end + blockSize <= pool + MaxCachedBytes || attempt != 0)
+		{
+			return end;
+		}
+		Compact();
+	}
+}
+
+// Read a directory into the cache, evicting the least recently used listings if necessary. The cache mutex must be owned.
+// We read the directory twice: first to find out how much memory we need, then to fill in the entries.
+/*static*/ DirectoryCache::Listing *_ecv_null DirectoryCache::Load(const char *_ecv_array directory, unsigned int volume) noexcept
+{
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	const uint16_t currentSeq = MassStorage::GetVolumeSeq(volume);
+	const uint32_t currentFilesWritten = numFilesWritten;
+
+	FileInfo fileInfo;
+	size_t numEntries = 0, namesLength = 0;
+	if (MassStorage::FindFirst(directory, fileInfo))
+	{
+		do
+		{
+			if (fileInfo.fileName[0] != '.')				// ignore Mac resource files and Linux hidden files
+			{
+				++numEntries;
+				namesLength += fileInfo.fileName.strlen() + 1;
+				if (BlockSizeNeeded(numEntries, namesLength) > MaxCachedBytes)
+				{
+					MassStorage::AbandonFindNext();
+					++numTooLarge;
+					return nullptr;
+				}
+			}
+		} while (MassStorage::FindNext(fileInfo));
+	}
+
+	// Find a free listing, evicting the least recently used ones until there is enough space in the pool
+	const size_t blockSize = BlockSizeNeeded(numEntries, namesLength);
+	Listing *_ecv_null slot;
+	for (;;)
+	{
+		slot = nullptr;
+		Listing *_ecv_null lruListing = nullptr;
+		for (Listing& l : listings)
+		{
+			if (l.IsFree())
+			{
+				if (slot == nullptr)
+				{
+					slot = &l;
+				}
+			}
+			else if (lruListing == nullptr || (int32_t)(l.lastUsed - lruListing->lastUsed) < 0)
+			{
+				lruListing = &l;
+			}
+		}
+
+		if (slot != nullptr && bytesCached + blockSize <= MaxCachedBytes)
+		{
+			break;
+		}
+		Free(*lruListing);									// lruListing can't be null because the cache can't be empty if we get here
+	}
+
+	char *_ecv_array const block = AllocateBlock(blockSize);
+	slot->entries = reinterpret_cast<Entry *_ecv_array>(block);
+	slot->names = block + numEntries * sizeof(Entry);
+	size_t entriesRead = 0, namesRead = 0;
+	bool tooMany = false;
+	if (MassStorage::FindFirst(directory, fileInfo))
+	{
+		do
+		{
+			if (fileInfo.fileName[0] != '.')
+			{
+				const size_t nameLength = fileInfo.fileName.strlen() + 1;
+				if (entriesRead == numEntries || namesRead + nameLength > namesLength)
+				{
+					// Another task added files to the directory since we counted them
+					MassStorage::AbandonFindNext();
+					tooMany = true;
+					break;
+				}
+				Entry& e = slot->entries[entriesRead++];
+				e.size = fileInfo.size;
+				e.lastModified = (uint32_t)fileInfo.lastModified;
+				e.nameOffset = namesRead;
+				e.isDirectory = fileInfo.isDirectory;
+				memcpy(slot->names + namesRead, fileInfo.fileName.c_str(), nameLength);
+				namesRead += nameLength;
+			}
+		} while (MassStorage::FindNext(fileInfo));
+	}
+
+	slot->numEntries = numEntries;
+	slot->namesLength = namesLength;
+	bytesCached += blockSize;
+	if (tooMany || entriesRead != numEntries)
+	{
+		Free(*slot);
+		return nullptr;
+	}
+
+	slot->volume = volume;
+	slot->seq = currentSeq;
+	slot->filesWritten = currentFilesWritten;
+	slot->path.copy(directory);
+
+	const uint32_t loadTicks = StepTimer::GetTimerTicks() - startTicks;
+	if (loadTicks > longestLoadTicks)
+	{
+		longestLoadTicks = loadTicks;
+	}
+	return slot;
+}
+
+/*static*/ bool DirectoryCache::IterateWhile(const char *_ecv_array directory, unsigned int startAt, function_ref<bool(unsigned int index, const FileInfo& info) /*noexcept*/ > func) noexcept
+{
+	// Use the same form of the directory name for all requests, so that "0:/gcodes/" finds the listing of "0:/gcodes"
+	String<MaxFilenameLength> dir;
+	dir.copy(directory);
+	const size_t len = dir.strlen();
+	if (len > 1 && (dir[len - 1] == '/' || dir[len - 1] == '\\'))
+	{
+		dir.Truncate(len - 1);
+	}
+	const unsigned int volume = (isdigit(dir[0]) && dir[1] == ':') ? dir[0] - '0' : 0;
+	if (volume >= MassStorage::GetNumVolumes())
+	{
+		return false;
+	}
+
+	MutexLocker lock(cacheMutex);
+	Listing *_ecv_null listing = Find(dir.c_str(), volume);
+	if (listing != nullptr)
+	{
+		++numHits;
+	}
+	else
+	{
+		++numMisses;
+		listing = Load(dir.c_str(), volume);
+		if (listing == nullptr)
+		{
+			return false;
+		}
+	}
+
+	listing->lastUsed = ++useCounter;
+	FileInfo fileInfo;
+	for (unsigned int i = startAt; i < listing->numEntries; ++i)
+	{
+		const Entry& e = listing->entries[i];
+		fileInfo.fileName.copy(listing->names + e.nameOffset);
+		fileInfo.size = e.size;
+		fileInfo.lastModified = (time_t)e.lastModified;
+		fileInfo.isDirectory = e.isDirectory;
+		if (!func(i, fileInfo))
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+/*static*/ void DirectoryCache::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int numCached = 0;
+	size_t numEntries = 0;
+	for (const Listing& l : listings)
+	{
+		if (!l.IsFree())
+		{
+			++numCached;
+			numEntries += l.numEntries;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "Directory cache: %u directories with %u files using %u bytes, %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " too large, longest load %.1fms\n",
+									numCached, numEntries, bytesCached, numHits, numMisses, numTooLarge, (double)((float)longestLoadTicks * StepClocksToMillis));
+	numHits = numMisses = numTooLarge = longestLoadTicks = 0;
+}
+
+#endif
+
+// End
@@ -0,0 +1,101 @@
+/*
+ * DirectoryCache.h
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_STORAGE_DIRECTORYCACHE_H_
+#define SRC_STORAGE_DIRECTORYCACHE_H_
+
+#include <RepRapFirmware.h>
+#include <General/function_ref.h>
+
+#if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+# define SUPPORT_DIRECTORY_CACHE	(1)		// keep listings of recently listed directories in RAM
+#else
+# define SUPPORT_DIRECTORY_CACHE	(0)
+#endif
+
+#if SUPPORT_DIRECTORY_CACHE
+
+#include <RTOSIface/RTOSIface.h>
+
+struct FileInfo;
+
+// Cache of the contents of recently listed directories, so that paginated file list requests don't have to read the directory
+// from the start for each page. Each listing holds the files in the order that FatFs returns them and excludes hidden files, so the index
+// of a file is the same as the 'first' and 'next' values in file list responses whether or not the directory could be cached.
+// A listing is rebuilt when the sequence number of its volume changes, or when a file that was open for writing is closed.
+// The listings are held in a statically allocated pool, so that reading a large directory doesn't use or fragment the heap.
+class DirectoryCache
+{
+public:
+	static void Init() noexcept;
+
+	// Call 'func' for each file in the directory starting at index 'startAt' until it returns false.
+	// Return false without calling 'func' if the directory is too large to cache or could not be read, in which case the caller should search the directory instead.
+	static bool IterateWhile(const char *_ecv_array directory, unsigned int startAt, function_ref<bool(unsigned int index, const FileInfo& info) /*noexcept*/ > func) noexcept;
+
+	static void FileClosedAfterWriting() noexcept { ++numFilesWritten; }
+	static void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	struct Entry
+	{
+		uint32_t size;
+		uint32_t lastModified;
+		uint16_t nameOffset;
+		bool isDirectory;
+	};
+
+	struct Listing
+	{
+		Listing() noexcept : entries(nullptr), names(nullptr), numEntries(0), namesLength(0), lastUsed(0), filesWritten(0), seq(0), volume(0) { }
+
+		char *_ecv_array Block() const noexcept { return reinterpret_cast<char *_ecv_array>(entries); }
+		size_t BlockSize() const noexcept { return BlockSizeNeeded(numEntries, namesLength); }
+
+		bool IsFree() const noexcept { return path.IsEmpty(); }
+
+		Entry *_ecv_array _ecv_null entries;			// points into the pool, and the names follow the entries
+		char *_ecv_array _ecv_null names;
+		size_t numEntries;
+		size_t namesLength;
+		uint32_t lastUsed;
+		uint32_t filesWritten;						// the value of numFilesWritten when we read the directory
+		uint16_t seq;								// the volume sequence number when we read the directory
+		uint8_t volume;
+		String<MaxFilenameLength> path;
+	};
+
+	static Listing *_ecv_null Find(const char *_ecv_array directory, unsigned int volume) noexcept;
+	static Listing *_ecv_null Load(const char *_ecv_array directory, unsigned int volume) noexcept;
+	static void Free(Listing& listing) noexcept;
+	static char *_ecv_array AllocateBlock(size_t blockSize) noexcept;
+	static void Compact() noexcept;
+
+	// Return the pool space needed for a listing, rounded up so that the entries of the next listing are aligned.
+	// An empty directory still takes 4 bytes so that no two listings start at the same address.
+	static size_t BlockSizeNeeded(size_t numEntries, size_t namesLength) noexcept { return (numEntries * sizeof(Entry) + namesLength + 4) & ~(size_t)3; }
+
+#if SAME70
+	static constexpr size_t NumListings = 3;
+	static constexpr size_t MaxCachedBytes = 48 * 1024;
+#else
+	static constexpr size_t NumListings = 2;
+	static constexpr size_t MaxCachedBytes = 8 * 1024;
+#endif
+
+	static Listing listings[NumListings];
+	alignas(4) static char pool[MaxCachedBytes];
+	static Mutex cacheMutex;
+	static size_t bytesCached;
+	static uint32_t useCounter;
+	static volatile uint32_t numFilesWritten;
+	static uint32_t numHits, numMisses, numTooLarge;
+	static uint32_t longestLoadTicks;
+};
+
+#endif
+
+#endif /* SRC_STORAGE_DIRECTORYCACHE_H_ */
@@ -120,6 +120,14 @@ public:
 	{
 		return not_null(f)->Flush();
 	}
+
+#  if SUPPORT_BACKGROUND_WRITES
+	bool CanWriteWithoutWaiting(size_t len) const noexcept
+	pre(IsLive())
+	{
+		return not_null(f)->CanWriteWithoutWaiting(len);
+	}
+#  endif
 # endif
 
 	FilePosition GetPosition() const noexcept
@@ -16,6 +16,9 @@
 
 FileInfoParser::FileInfoParser() noexcept
 	: parseState(notParsing), fileBeingParsed(nullptr), accumulatedParseTime(0), accumulatedReadTime(0), accumulatedSeekTime(0), fileOverlapLength(0)
+#if SUPPORT_FILE_INFO_CACHE
+	  , numQueued(0), cacheUseCounter(0), numCacheHits(0), numCacheMisses(0), numBackgroundScans(0), backgroundParse(false)
+#endif
 {
 	parsedFileInfo.Init();
 	parserMutex.Create("FileInfoParser");
@@ -30,6 +33,38 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 		return GCodeResult::notFinished;
 	}
 
+#if SUPPORT_FILE_INFO_CACHE
+	if (parseState != notParsing && backgroundParse)
+	{
+		if (StringEqualsIgnoreCase(filePath, filenameBeingParsed.c_str()))
+		{
+			backgroundParse = false;						// a client wants the file we are parsing in the background, so finish it for them
+		}
+		else
+		{
+			// Don't make the client wait for a background parse to finish. Abandon it and start it again later.
+			AbandonBackgroundParse(true);
+		}
+	}
+
+	if (parseState == notParsing)
+	{
+		backgroundParse = false;
+		if (LookupCachedInfo(filePath, info))
+		{
+			++numCacheHits;
+			return GCodeResult::ok;
+		}
+		++numCacheMisses;
+	}
+#endif
+
+	return ParseFile(filePath, info, quitEarly);
+}
+
+// Parse the file a chunk at a time. The parser mutex must be owned.
+GCodeResult FileInfoParser::ParseFile(const char *filePath, GCodeFileInfo& info, bool quitEarly) noexcept
+{
 	if (parseState != notParsing && !StringEqualsIgnoreCase(filePath, filenameBeingParsed.c_str()))
 	{
 		// We are already parsing a different file
@@ -344,6 +379,10 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 					}
 					parsedFileInfo.incomplete = false;
 					info = parsedFileInfo;
+#if SUPPORT_FILE_INFO_CACHE
+					StoreCachedInfo(filePath, parsedFileInfo);
+					backgroundParse = false;
+#endif
 					return GCodeResult::ok;
 				}
 
@@ -362,6 +401,12 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 			return GCodeResult::ok;
 		}
 		lastFileParseTime = millis();
+#if SUPPORT_FILE_INFO_CACHE
+		if (backgroundParse)
+		{
+			break;											// only do one chunk at a time when parsing in the background
+		}
+#endif
 	} while (!reprap.GetPrintMonitor().IsPrinting() && lastFileParseTime - loopStartTime < MAX_FILEINFO_PROCESS_TIME);
 
 	if (quitEarly)
@@ -1052,6 +1097,192 @@ bool FileInfoParser::FindThumbnails(const char *_ecv_array bufp, FilePosition bu
 	}
 }
 
+#if SUPPORT_FILE_INFO_CACHE
+
+// Look for the results of parsing the file in the cache. The entry is only used if the size and date of the file have not changed.
+// The parser mutex must be owned.
+bool FileInfoParser::LookupCachedInfo(const char *_ecv_array filePath, GCodeFileInfo& info) noexcept
+{
+	for (CachedFileInfo& c : cachedInfo)
+	{
+		if (!c.filePath.IsEmpty() && StringEqualsIgnoreCase(filePath, c.filePath.c_str()))
+		{
+			FilePosition size;
+			time_t lastModified;
+			if (MassStorage::GetFileSizeAndTime(filePath, size, lastModified) && size == c.info.fileSize && lastModified == c.info.lastModifiedTime)
+			{
+				c.lastUsed = ++cacheUseCounter;
+				info = c.info;
+				return true;
+			}
+			c.filePath.Clear();								// the file has been changed or deleted
+			break;
+		}
+	}
+	return false;
+}
+
+// Store the results of parsing a file, replacing the least recently used entry if necessary. The parser mutex must be owned.
+void FileInfoParser::StoreCachedInfo(const char *_ecv_array filePath, const GCodeFileInfo& info) noexcept
+{
+	CachedFileInfo *slot = &cachedInfo[0];
+	for (CachedFileInfo& c : cachedInfo)
+	{
+		if (c.filePath.IsEmpty() || StringEqualsIgnoreCase(filePath, c.filePath.c_str()))
+		{
+			slot = &c;
+			break;
+		}
+		if ((int32_t)(c.lastUsed - slot->lastUsed) < 0)
+		{
+			slot = &c;
+		}
+	}
+	slot->filePath.copy(filePath);
+	slot->info = info;
+	slot->lastUsed = ++cacheUseCounter;
+}
+
+// Forget what we know about a file because it has been changed without changing its size or date
+void FileInfoParser::ForgetFile(const char *_ecv_array filePath) noexcept
+{
+	MutexLocker lock(parserMutex);
+	for (CachedFileInfo& c : cachedInfo)
+	{
+		if (StringEqualsIgnoreCase(filePath, c.filePath.c_str()))
+		{
+			c.filePath.Clear();
+		}
+	}
+}
+
+// Close the file we were parsing in the background, optionally queueing it to be parsed again later. The parser mutex must be owned.
+void FileInfoParser::AbandonBackgroundParse(bool requeue) noexcept
+{
+	fileBeingParsed->Close();
+	parseState = notParsing;
+	backgroundParse = false;
+	if (requeue)
+	{
+		QueueBackgroundScan(filenameBeingParsed.c_str());
+	}
+}
+
+// Stop parsing a file in the background and remove it from the queue, so that it isn't open when it is deleted or renamed
+void FileInfoParser::StopBackgroundScan(const char *_ecv_array filePath) noexcept
+{
+	MutexLocker lock(parserMutex);
+	if (parseState != notParsing && backgroundParse && StringEqualsIgnoreCase(filePath, filenameBeingParsed.c_str()))
+	{
+		AbandonBackgroundParse(false);
+	}
+
+	TaskCriticalSectionLocker queueLock;
+	size_t i = 0;
+	while (i < numQueued)
+	{
+		if (StringEqualsIgnoreCase(filePath, backgroundQueue[i].c_str()))
+		{
+			--numQueued;
+			for (size_t j = i; j < numQueued; ++j)
+			{
+				backgroundQueue[j].copy(backgroundQueue[j + 1].c_str());
+			}
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+// Queue a file to be parsed in the background. If the queue is full then the file will be parsed when a client asks for it.
+void FileInfoParser::QueueBackgroundScan(const char *_ecv_array filePath) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	for (size_t i = 0; i < numQueued; ++i)
+	{
+		if (StringEqualsIgnoreCase(filePath, backgroundQueue[i].c_str()))
+		{
+			return;
+		}
+	}
+	if (numQueued < BackgroundQueueLength)
+	{
+		backgroundQueue[numQueued++].copy(filePath);
+	}
+}
+
+// Parse the next chunk of a queued file. This is called by MassStorage::Spin, so it must not hold up the main task for long.
+void FileInfoParser::Spin() noexcept
+{
+	// Don't wait if a client is using the parser
+	MutexLocker lock(parserMutex, 0);
+	if (!lock.IsAcquired())
+	{
+		return;
+	}
+
+	// Don't compete with a print for the SD card. Close any file we were parsing so that it isn't held open for the whole print.
+	if (reprap.GetPrintMonitor().IsPrinting())
+	{
+		if (parseState != notParsing && backgroundParse)
+		{
+			AbandonBackgroundParse(true);
+		}
+		return;
+	}
+
+	// We use parsedFileInfo to receive the results, because we don't need another copy of them
+	if (parseState == notParsing)
+	{
+		String<MaxFilenameLength> filePath;
+		{
+			TaskCriticalSectionLocker queueLock;
+			if (numQueued == 0)
+			{
+				return;
+			}
+			filePath.copy(backgroundQueue[0].c_str());
+			--numQueued;
+			for (size_t i = 0; i < numQueued; ++i)
+			{
+				backgroundQueue[i].copy(backgroundQueue[i + 1].c_str());
+			}
+		}
+
+		if (!LookupCachedInfo(filePath.c_str(), parsedFileInfo))
+		{
+			backgroundParse = true;
+			++numBackgroundScans;
+			(void)ParseFile(filePath.c_str(), parsedFileInfo, false);
+		}
+	}
+	else if (backgroundParse)
+	{
+		String<MaxFilenameLength> filePath;
+		filePath.copy(filenameBeingParsed.c_str());
+		(void)ParseFile(filePath.c_str(), parsedFileInfo, false);
+	}
+}
+
+void FileInfoParser::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int numCached = 0;
+	for (const CachedFileInfo& c : cachedInfo)
+	{
+		if (!c.filePath.IsEmpty())
+		{
+			++numCached;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "File info cache: %u files, %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " background scans, %u queued\n",
+									numCached, numCacheHits, numCacheMisses, numBackgroundScans, numQueued);
+	numCacheHits = numCacheMisses = numBackgroundScans = 0;
+}
+
+#endif
+
 #endif
 
 // End
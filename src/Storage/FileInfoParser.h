@@ -31,6 +31,12 @@ const size_t GCODE_OVERLAP_SIZE = 100;				// Size of the overlapping buffer for
 const uint32_t MAX_FILEINFO_PROCESS_TIME = 200;		// Maximum time to spend polling for file info in each call
 const uint32_t MaxFileParseInterval = 4000;			// Maximum interval between repeat requests to parse a file
 
+#if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+# define SUPPORT_FILE_INFO_CACHE	(1)				// keep the results of parsing recently used G-code files in RAM, and parse uploaded files in the background
+#else
+# define SUPPORT_FILE_INFO_CACHE	(0)
+#endif
+
 enum FileParseState
 {
 	notParsing,
@@ -47,9 +53,46 @@ public:
 	// The following method needs to be called repeatedly until it doesn't return GCodeResult::notFinished - this may take a few runs
 	GCodeResult GetFileInfo(const char *filePath, GCodeFileInfo& info, bool quitEarly) noexcept;
 
+#if SUPPORT_FILE_INFO_CACHE
+	void QueueBackgroundScan(const char *_ecv_array filePath) noexcept;	// ask for a file to be parsed in the background, e.g. because it has just been uploaded
+	void ForgetFile(const char *_ecv_array filePath) noexcept;			// discard the cached information about a file
+	void StopBackgroundScan(const char *_ecv_array filePath) noexcept;	// stop parsing a file in the background because it is about to be deleted or renamed
+	void Spin() noexcept;												// parse the queued files a chunk at a time
+	void Diagnostics(MessageType mtype) noexcept;
+#endif
+
 	static constexpr const char *_ecv_array SimulatedTimeString = "\n; Simulated print time";	// used by FileInfoParser and MassStorage
 
 private:
+	GCodeResult ParseFile(const char *filePath, GCodeFileInfo& info, bool quitEarly) noexcept;
+
+#if SUPPORT_FILE_INFO_CACHE
+	// The results of parsing a file. The entry is only valid while the size and date of the file are unchanged.
+	struct CachedFileInfo
+	{
+		String<MaxFilenameLength> filePath;
+		GCodeFileInfo info;
+		uint32_t lastUsed;
+	};
+
+	bool LookupCachedInfo(const char *_ecv_array filePath, GCodeFileInfo& info) noexcept;
+	void StoreCachedInfo(const char *_ecv_array filePath, const GCodeFileInfo& info) noexcept;
+	void AbandonBackgroundParse(bool requeue) noexcept;
+
+# if SAME70
+	static constexpr size_t NumCachedFiles = 16;
+# else
+	static constexpr size_t NumCachedFiles = 8;
+# endif
+	static constexpr size_t BackgroundQueueLength = 4;
+
+	CachedFileInfo cachedInfo[NumCachedFiles];
+	String<MaxFilenameLength> backgroundQueue[BackgroundQueueLength];
+	size_t numQueued;
+	uint32_t cacheUseCounter;
+	uint32_t numCacheHits, numCacheMisses, numBackgroundScans;
+	bool backgroundParse;											// true if the file being parsed was queued for background parsing
+#endif
 
 	// G-Code parser methods
 	bool FindHeight(const char *_ecv_array bufp, size_t len) noexcept;
@@ -16,12 +16,41 @@
 #if HAS_MASS_STORAGE
 # include <Libraries/Fatfs/diskio.h>
 # include <Movement/StepTimer.h>
+# include "DirectoryCache.h"
 #endif
 
 #if HAS_SBC_INTERFACE
 # include <SBC/SbcInterface.h>
 #endif
 
+#if SUPPORT_MACRO_CACHE
+# include "MacroCache.h"
+#endif
+
+#if SUPPORT_BACKGROUND_WRITES
+# include <Platform/TaskPriorities.h>
+
+constexpr size_t FileWriterTaskStackWords = 400;
+static Task<FileWriterTaskStackWords> fileWriterTask;
+
+FileStore *volatile FileStore::queuedWrite = nullptr;
+FileStore *volatile FileStore::activeWrite = nullptr;
+uint32_t FileStore::backgroundBytesWritten = 0;
+uint32_t FileStore::backgroundWriteTicks = 0;
+uint32_t FileStore::numBackgroundWrites = 0;
+uint32_t FileStore::numBackgroundWaits = 0;
+#endif
+
+#if SUPPORT_FAST_SEEK
+DWORD FileStore::clusterMaps[NumClusterMaps][ClusterMapSize];
+bool FileStore::clusterMapInUse[NumClusterMaps] = { 0 };
+uint32_t FileStore::numMapsCreated = 0;
+uint32_t FileStore::numMapsTooFragmented = 0;
+uint32_t FileStore::numMapsUnavailable = 0;
+uint32_t FileStore::numFastSeeks = 0;
+uint32_t FileStore::longestMapCreateTicks = 0;
+#endif
+
 FileStore::FileStore() noexcept
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	: writeBuffer(nullptr)
@@ -44,7 +73,19 @@ void FileStore::Init() noexcept
 	handle = noFileHandle;
 	length = 0;
 #endif
-#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+#if SUPPORT_MACRO_CACHE
+	cachedMacro = nullptr;
+#endif
+#if SUPPORT_BACKGROUND_WRITES
+	spareWriteBuffer = nullptr;
+	backgroundWriteFailed = false;
+	backgroundVolume = 0;
+#endif
+#if SUPPORT_FAST_SEEK
+	clusterMap = nullptr;
+	clusterMapFailed = false;
+#endif
+#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE || SUPPORT_MACRO_CACHE
 	offset = 0;
 #endif
 }
@@ -126,21 +167,52 @@ bool FileStore::Open(const char *_ecv_array filePath, OpenMode mode, uint32_t pr
 # endif
 # if HAS_MASS_STORAGE
 	{
-		const FRESULT openReturn = f_open(&file, filePath,
-											(mode == OpenMode::write || mode == OpenMode::writeWithCrc) ? FA_CREATE_ALWAYS | FA_WRITE
-												: (mode == OpenMode::append) ? FA_READ | FA_WRITE | FA_OPEN_ALWAYS | FA_OPEN_APPEND
-													: FA_OPEN_EXISTING | FA_READ);
-		if (openReturn == FR_OK)
+#  if SUPPORT_MACRO_CACHE
+		// If we are opening a macro file, see if we already have its contents
+		if (mode == OpenMode::readCached)
 		{
-			fileOpened = true;
+			cachedMacro = MacroCache::Acquire(filePath);
+			offset = 0;
+			fileOpened = (cachedMacro != nullptr);
 		}
-		else
+
+		if (!fileOpened)
+#  endif
 		{
-			// We no longer report an error if opening a file in read mode fails unless debugging is enabled, because sometimes that is quite normal.
-			// It is up to the caller to report an error if necessary.
-			if (reprap.Debug(moduleStorage))
+			const FRESULT openReturn = f_open(&file, filePath,
+												(mode == OpenMode::write || mode == OpenMode::writeWithCrc) ? FA_CREATE_ALWAYS | FA_WRITE
+													: (mode == OpenMode::append) ? FA_READ | FA_WRITE | FA_OPEN_ALWAYS | FA_OPEN_APPEND
+														: FA_OPEN_EXISTING | FA_READ);
+			if (openReturn == FR_OK)
 			{
-				reprap.GetPlatform().MessageF(WarningMessage, "Failed to open %s to %s, error code %d\n", filePath, (writing) ? "write" : "read", (int)openReturn);
+				fileOpened = true;
+#  if SUPPORT_FAST_SEEK
+				clusterMapFailed = false;							// f_open has cleared the cluster map pointer in the file object
+#  endif
+#  if SUPPORT_MACRO_CACHE
+				if (mode == OpenMode::readCached)
+				{
+					// Try to read the whole file into the cache so that we don't need to read it next time
+					cachedMacro = MacroCache::Load(filePath, file);
+					if (cachedMacro != nullptr)
+					{
+						(void)f_close(&file);
+					}
+					else
+					{
+						(void)f_lseek(&file, 0);
+					}
+				}
+#  endif
+			}
+			else
+			{
+				// We no longer report an error if opening a file in read mode fails unless debugging is enabled, because sometimes that is quite normal.
+				// It is up to the caller to report an error if necessary.
+				if (reprap.Debug(moduleStorage))
+				{
+					reprap.GetPlatform().MessageF(WarningMessage, "Failed to open %s to %s, error code %d\n", filePath, (writing) ? "write" : "read", (int)openReturn);
+				}
 			}
 		}
 	}
@@ -245,6 +317,13 @@ bool FileStore::Seek(FilePosition pos) noexcept
 
 	case FileUseMode::readOnly:
 	case FileUseMode::readWrite:
+#if SUPPORT_MACRO_CACHE
+		if (cachedMacro != nullptr)
+		{
+			offset = min<FilePosition>(pos, cachedMacro->GetLength());
+			return true;
+		}
+#endif
 #if HAS_SBC_INTERFACE
 		if (reprap.UsingSbcInterface())
 		{
@@ -257,6 +336,16 @@ bool FileStore::Seek(FilePosition pos) noexcept
 		}
 #endif
 #if HAS_MASS_STORAGE
+# if SUPPORT_FAST_SEEK
+		if (clusterMap == nullptr && WantClusterMap(pos))
+		{
+			CreateClusterMap();
+		}
+		if (clusterMap != nullptr)
+		{
+			++numFastSeeks;
+		}
+# endif
 		return f_lseek(&file, pos) == FR_OK;
 #elif HAS_EMBEDDED_FILES
 		offset = min<FilePosition>(pos, EmbeddedFiles::Length(fileIndex));
@@ -273,6 +362,12 @@ bool FileStore::Seek(FilePosition pos) noexcept
 
 FilePosition FileStore::Position() const noexcept
 {
+#if SUPPORT_MACRO_CACHE
+	if (cachedMacro != nullptr)
+	{
+		return offset;
+	}
+#endif
 #if HAS_SBC_INTERFACE
 	if (reprap.UsingSbcInterface())
 	{
@@ -297,6 +392,12 @@ FilePosition FileStore::Length() const noexcept
 		return 0;
 
 	case FileUseMode::readOnly:
+#if SUPPORT_MACRO_CACHE
+		if (cachedMacro != nullptr)
+		{
+			return cachedMacro->GetLength();
+		}
+#endif
 #if HAS_SBC_INTERFACE
 		if (reprap.UsingSbcInterface())
 		{
@@ -383,6 +484,15 @@ int FileStore::Read(char *_ecv_array extBuf, size_t nBytes) noexcept
 
 	case FileUseMode::readOnly:
 	case FileUseMode::readWrite:
+#if SUPPORT_MACRO_CACHE
+		if (cachedMacro != nullptr)
+		{
+			const size_t bytesRead = min<size_t>(nBytes, cachedMacro->GetLength() - offset);
+			memcpy(extBuf, cachedMacro->GetData() + offset, bytesRead);
+			offset += bytesRead;
+			return (int)bytesRead;
+		}
+#endif
 #if HAS_SBC_INTERFACE
 		if (reprap.UsingSbcInterface())
 		{
@@ -475,6 +585,28 @@ bool FileStore::ForceClose() noexcept
 	}
 #endif
 
+#if SUPPORT_BACKGROUND_WRITES
+	if (spareWriteBuffer != nullptr)
+	{
+		(void)WaitForBackgroundWrite();			// Flush has already done this unless the file was invalidated
+		MassStorage::ReleaseWriteBuffer(spareWriteBuffer);
+		spareWriteBuffer = nullptr;
+	}
+#endif
+
+#if SUPPORT_MACRO_CACHE
+	if (cachedMacro != nullptr)
+	{
+		MacroCache::Release(cachedMacro);
+		cachedMacro = nullptr;
+		usageMode = FileUseMode::free;
+		closeRequested = false;
+		openCount = 0;
+		reprap.VolumesUpdated();
+		return ok;
+	}
+#endif
+
 #if HAS_SBC_INTERFACE
 	if (reprap.UsingSbcInterface())
 	{
@@ -487,7 +619,19 @@ bool FileStore::ForceClose() noexcept
 #endif
 
 #if HAS_MASS_STORAGE
+# if SUPPORT_FAST_SEEK
+	ReleaseClusterMap();
+# endif
 	const FRESULT fr = f_close(&file);
+	if (usageMode == FileUseMode::readWrite)
+	{
+# if SUPPORT_DIRECTORY_CACHE
+		DirectoryCache::FileClosedAfterWriting();		// the size and date of the file in its directory listing have changed
+# endif
+# if SUPPORT_MACRO_CACHE
+		MacroCache::FileClosedAfterWriting();			// the file may be a macro that we have cached, or we may have cached it while it was being written
+# endif
+	}
 	usageMode = FileUseMode::free;
 	closeRequested = false;
 	openCount = 0;
@@ -601,15 +745,24 @@ bool FileStore::Write(const char *_ecv_array s, size_t len) noexcept
 					const size_t bytesStored = writeBuffer->Store(s + totalBytesWritten, len - totalBytesWritten);
 					if (writeBuffer->BytesLeft() == 0)
 					{
-						const size_t bytesToWrite = writeBuffer->BytesStored();
-						size_t bytesWritten;
-						writeOk = Store(writeBuffer->Data(), bytesToWrite, &bytesWritten);
-						writeBuffer->DataTaken();
-
-						if (bytesToWrite != bytesWritten)
+#if SUPPORT_BACKGROUND_WRITES
+						if (spareWriteBuffer != nullptr)
+						{
+							writeOk = QueueBackgroundWrite();
+						}
+						else
+#endif
 						{
-							// Something went wrong
-							break;
+							const size_t bytesToWrite = writeBuffer->BytesStored();
+							size_t bytesWritten;
+							writeOk = Store(writeBuffer->Data(), bytesToWrite, &bytesWritten);
+							writeBuffer->DataTaken();
+
+							if (bytesToWrite != bytesWritten)
+							{
+								// Something went wrong
+								break;
+							}
 						}
 					}
 					totalBytesWritten += bytesStored;
@@ -642,6 +795,12 @@ bool FileStore::Flush() noexcept
 		return true;
 
 	case FileUseMode::readWrite:
+#if SUPPORT_BACKGROUND_WRITES
+		if (spareWriteBuffer != nullptr && !WaitForBackgroundWrite())
+		{
+			return false;
+		}
+#endif
 		if (writeBuffer != nullptr)
 		{
 			const size_t bytesToWrite = writeBuffer->BytesStored();
@@ -704,7 +863,18 @@ bool FileStore::Invalidate(const FATFS *fs, bool doClose) noexcept
 		}
 		else
 		{
+# if SUPPORT_BACKGROUND_WRITES
+			if (spareWriteBuffer != nullptr)
+			{
+				(void)WaitForBackgroundWrite();
+				MassStorage::ReleaseWriteBuffer(spareWriteBuffer);
+				spareWriteBuffer = nullptr;
+			}
+# endif
 			file.obj.fs = nullptr;
+# if SUPPORT_FAST_SEEK
+			ReleaseClusterMap();
+# endif
 			if (writeBuffer != nullptr)
 			{
 				MassStorage::ReleaseWriteBuffer(writeBuffer);
@@ -734,38 +904,257 @@ uint32_t FileStore::ClusterSize() const noexcept
 	return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite) ? file.obj.fs->csize * 512u : 1;	// we divide by the cluster size so return 1 not 0 if there is an error
 }
 
-#endif	// HAS_MASS_STORAGE
+#if SUPPORT_BACKGROUND_WRITES
 
-#if 0	// these are not currently used
+extern "C" [[noreturn]] void FileWriterTask(void *) noexcept
+{
+	FileStore::BackgroundWriterLoop();
+}
 
-bool FileStore::GoToEnd()
+/*static*/ void FileStore::BackgroundWriterInit() noexcept
 {
-	return Seek(Length());
+	fileWriterTask.Create(FileWriterTask, "FILEWRITE", nullptr, TaskPriority::SpinPriority);
 }
 
-// Provide a cluster map for fast seeking. Needs _USE_FASTSEEK defined as 1 in conf_fatfs to make any difference.
-// The first element of the table must be set to the total number of 32-bit entries in the table before calling this.
-bool FileStore::SetClusterMap(uint32_t tbl[]) noexcept
+static_assert(NumFileWriteBuffers >= 3, "Background writing needs a spare write buffer that leaves one free for other files");
+
+// Get a second write buffer so that one can be filled while the file writer task writes the other one to the card.
+// Only network uploads use this, because they are the only writers that have something useful to do while the card is busy.
+// We don't take the last free buffer, because then no other file could be opened for writing until the upload finished.
+bool FileStore::StartBackgroundWriting() noexcept
 {
-	switch (usageMode)
+	if (usageMode != FileUseMode::readWrite || writeBuffer == nullptr || spareWriteBuffer != nullptr
+# if HAS_SBC_INTERFACE
+		|| reprap.UsingSbcInterface()
+# endif
+	   )
 	{
-	case FileUseMode::free:
-		INTERNAL_ERROR;
 		return false;
+	}
 
-	case FileUseMode::readOnly:
-	case FileUseMode::readWrite:
+	spareWriteBuffer = MassStorage::AllocateSpareWriteBuffer();
+	if (spareWriteBuffer == nullptr)
+	{
+		return false;
+	}
+	backgroundWriteFailed = false;
+	backgroundVolume = file.obj.fs->pdrv;
+	return true;
+}
+
+// Return true if we can store this many bytes without waiting for the card to finish writing a previous buffer
+bool FileStore::CanWriteWithoutWaiting(size_t len) const noexcept
+{
+	return spareWriteBuffer == nullptr || writeBuffer == nullptr || len < writeBuffer->BytesLeft() || (queuedWrite == nullptr && activeWrite == nullptr);
+}
+
+// Swap the full write buffer with the spare one and ask the file writer task to write it. Return false if writing the previous buffer failed.
+bool FileStore::QueueBackgroundWrite() noexcept
+{
+	if (!WaitForBackgroundWrite())
+	{
+		return false;
+	}
+
+	// Another file may be using the file writer task
+	if (queuedWrite != nullptr || activeWrite != nullptr)
+	{
+		++numBackgroundWaits;
+		do
 		{
-			file.cltbl = tbl;
-			const FRESULT ret = f_lseek(&file, CREATE_LINKMAP);
-//			debugPrintf("ret %d need %u\n", (int)ret, tbl[0]);
-			return ret == FR_OK;
+			delay(1);
+		} while (queuedWrite != nullptr || activeWrite != nullptr);
+	}
+
+	std::swap(writeBuffer, spareWriteBuffer);
+	queuedWrite = this;
+	fileWriterTask.Give();
+	return true;
+}
+
+// Wait until the file writer task has finished with our spare buffer, returning false if it failed to write it.
+// If the task hasn't started on it yet then we write it ourselves, so that we don't deadlock if our caller owns the volume mutex, e.g. when the card is being unmounted.
+bool FileStore::WaitForBackgroundWrite() noexcept
+{
+	if (ClaimQueuedWrite())
+	{
+		DoBackgroundWrite();
+	}
+	else if (activeWrite == this)
+	{
+		++numBackgroundWaits;
+		do
+		{
+			delay(1);
+		} while (activeWrite == this);
+	}
+	return !backgroundWriteFailed;
+}
+
+// If our spare buffer is waiting to be written, mark it as being written and return true
+bool FileStore::ClaimQueuedWrite() noexcept
+{
+	TaskCriticalSectionLocker lock;
+	if (queuedWrite != this)
+	{
+		return false;
+	}
+	queuedWrite = nullptr;
+	activeWrite = this;
+	return true;
+}
+
+// Write the spare buffer to the card. This also updates the CRC, which is safe because the task filling the other buffer waits for us before it uses the CRC or the file.
+void FileStore::DoBackgroundWrite() noexcept
+{
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	const size_t bytesToWrite = spareWriteBuffer->BytesStored();
+	size_t bytesWritten;
+	if (!Store(spareWriteBuffer->Data(), bytesToWrite, &bytesWritten) || bytesWritten != bytesToWrite)
+	{
+		backgroundWriteFailed = true;
+	}
+	spareWriteBuffer->DataTaken();
+	backgroundBytesWritten += bytesToWrite;
+	backgroundWriteTicks += StepTimer::GetTimerTicks() - startTicks;
+	++numBackgroundWrites;
+	activeWrite = nullptr;
+}
+
+/*static*/ void FileStore::BackgroundWriterLoop() noexcept
+{
+	for (;;)
+	{
+		TaskBase::Take(Mutex::TimeoutUnlimited);
+		FileStore * const f = queuedWrite;
+		if (f != nullptr)
+		{
+			// Take the volume mutex before claiming the write, so that a task that owns it can claim the write instead of waiting for us
+			const unsigned int volume = f->backgroundVolume;
+			MutexLocker lock(MassStorage::GetVolumeMutex(volume));
+			if (f->backgroundVolume == volume && f->ClaimQueuedWrite())
+			{
+				f->DoBackgroundWrite();
+			}
 		}
+	}
+}
 
-	case FileUseMode::invalidated:
-	default:
+/*static*/ void FileStore::BackgroundWriterDiagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Background writes: %" PRIu32 " buffers at %.2fMbytes/sec, %" PRIu32 " waits\n",
+									numBackgroundWrites,
+									(double)((float)backgroundBytesWritten * (float)StepClockRate * 0.000001/(float)max<uint32_t>(backgroundWriteTicks, 1)),
+									numBackgroundWaits);
+	backgroundBytesWritten = backgroundWriteTicks = numBackgroundWrites = numBackgroundWaits = 0;
+}
+
+#endif
+
+#if SUPPORT_FAST_SEEK
+
+// Decide whether we should build a cluster map before seeking to the specified position.
+// Without one, FatFs follows the FAT chain from the start of the file when seeking backwards, and from the current cluster when seeking forwards.
+// Seeks within the current cluster are cheap in either case. The map can only be used for reading, because FatFs can't extend a file in fast seek mode.
+bool FileStore::WantClusterMap(FilePosition pos) const noexcept
+{
+	if (usageMode != FileUseMode::readOnly || clusterMapFailed)
+	{
 		return false;
 	}
+	const FilePosition clusterSize = ClusterSize();
+	if (f_size(&file) < MinClustersForFastSeek * clusterSize)
+	{
+		return false;
+	}
+	const FilePosition currentPos = f_tell(&file);
+	return pos >= clusterSize && pos/clusterSize != currentPos/clusterSize && (pos < currentPos || pos - currentPos > clusterSize);
+}
+
+// Take a cluster map from the pool and build the link map for the file. If we can't, don't try again until the file is reopened.
+void FileStore::CreateClusterMap() noexcept
+{
+	{
+		TaskCriticalSectionLocker lock;
+		for (size_t i = 0; i < NumClusterMaps; ++i)
+		{
+			if (!clusterMapInUse[i])
+			{
+				clusterMapInUse[i] = true;
+				clusterMap = clusterMaps[i];
+				break;
+			}
+		}
+	}
+
+	if (clusterMap == nullptr)
+	{
+		++numMapsUnavailable;
+		return;											// the file may be closed soon, so try again next time
+	}
+
+	const uint32_t startTicks = StepTimer::GetTimerTicks();
+	clusterMap[0] = ClusterMapSize;
+	file.cltbl = clusterMap;
+	const FRESULT fr = f_lseek(&file, CREATE_LINKMAP);
+	const uint32_t ticks = StepTimer::GetTimerTicks() - startTicks;
+	if (ticks > longestMapCreateTicks)
+	{
+		longestMapCreateTicks = ticks;
+	}
+
+	if (fr == FR_OK)
+	{
+		++numMapsCreated;
+	}
+	else
+	{
+		if (fr == FR_NOT_ENOUGH_CORE)
+		{
+			++numMapsTooFragmented;
+		}
+		ReleaseClusterMap();
+		clusterMapFailed = true;
+	}
+}
+
+// Return the cluster map to the pool
+void FileStore::ReleaseClusterMap() noexcept
+{
+	if (clusterMap != nullptr)
+	{
+		file.cltbl = nullptr;
+		const size_t index = (clusterMap - clusterMaps[0])/ClusterMapSize;
+		clusterMap = nullptr;
+		TaskCriticalSectionLocker lock;
+		clusterMapInUse[index] = false;
+	}
+}
+
+/*static*/ void FileStore::FastSeekDiagnostics(MessageType mtype) noexcept
+{
+	unsigned int numInUse = 0;
+	for (bool b : clusterMapInUse)
+	{
+		if (b)
+		{
+			++numInUse;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "Fast seek: %u of %u cluster maps in use, %" PRIu32 " created, %" PRIu32 " too fragmented, %" PRIu32 " unavailable, %" PRIu32 " fast seeks, longest build %.1fms\n",
+									numInUse, NumClusterMaps, numMapsCreated, numMapsTooFragmented, numMapsUnavailable, numFastSeeks, (double)((float)longestMapCreateTicks * StepClocksToMillis));
+	numMapsCreated = numMapsTooFragmented = numMapsUnavailable = numFastSeeks = longestMapCreateTicks = 0;
+}
+
+#endif
+
+#endif	// HAS_MASS_STORAGE
+
+#if 0	// these are not currently used
+
+bool FileStore::GoToEnd()
+{
+	return Seek(Length());
 }
 
 #endif
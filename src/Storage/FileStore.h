@@ -14,6 +14,25 @@
 class Platform;
 class FileWriteBuffer;
 
+#if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+# define SUPPORT_MACRO_CACHE	(1)		// keep the contents of recently used macro files in RAM
+class MacroCacheEntry;
+#else
+# define SUPPORT_MACRO_CACHE	(0)
+#endif
+
+#if HAS_MASS_STORAGE && FF_USE_FASTSEEK
+# define SUPPORT_FAST_SEEK		(1)		// build cluster link maps so that seeking within large files doesn't need to follow the FAT chain
+#else
+# define SUPPORT_FAST_SEEK		(0)
+#endif
+
+#if HAS_MASS_STORAGE && SAME70
+# define SUPPORT_BACKGROUND_WRITES	(1)		// allow full write buffers to be written to the card by the file writer task. Needs a third write buffer, so only on SAME70.
+#else
+# define SUPPORT_BACKGROUND_WRITES	(0)
+#endif
+
 #if HAS_EMBEDDED_FILES
 typedef int32_t FileIndex;
 #endif
@@ -23,6 +42,7 @@ typedef int32_t FileIndex;
 enum class OpenMode : uint8_t
 {
 	read,			// open an existing file for reading
+	readCached,		// as read but use the macro cache if we have one
 	write,			// write a file, replacing any existing file of the same name
 	writeWithCrc,	// as write but calculate the CRC as we go
 	append			// append to an existing file, or create a new file if it is not found
@@ -79,11 +99,19 @@ public:
 	bool Invalidate(const FATFS *fs, bool doClose) noexcept;	// Invalidate the file if it uses the specified FATFS object
 	bool IsOpenOn(const FATFS *fs) const noexcept;				// Return true if the file is open on the specified file system
 	bool IsSameFile(const FIL& otherFile) const noexcept;		// Return true if the passed file is the same as ours
-# if 0	// not currently used
-	bool SetClusterMap(uint32_t[]) noexcept;					// Provide a cluster map for fast seeking
+# if SUPPORT_FAST_SEEK
+	static void FastSeekDiagnostics(MessageType mtype) noexcept;
 # endif
 #endif
 
+#if SUPPORT_BACKGROUND_WRITES
+	bool StartBackgroundWriting() noexcept;						// Have full write buffers written by the file writer task, returning false if we can't
+	bool CanWriteWithoutWaiting(size_t len) const noexcept;		// Return true if writing this many bytes won't have to wait for the card
+	static void BackgroundWriterInit() noexcept;
+	static void BackgroundWriterDiagnostics(MessageType mtype) noexcept;
+	[[noreturn]] static void BackgroundWriterLoop() noexcept;
+#endif
+
 #if 0	// not currently used
 	bool GoToEnd() noexcept;									// Position the file at the end (so you can write on the end).
 #endif
@@ -92,6 +120,19 @@ private:
 	void Init() noexcept;
 	bool Store(const char *_ecv_array s, size_t len, size_t *bytesWritten) noexcept;	// Write data to the non-volatile storage
 
+#if SUPPORT_BACKGROUND_WRITES
+	bool QueueBackgroundWrite() noexcept;
+	bool WaitForBackgroundWrite() noexcept;
+	bool ClaimQueuedWrite() noexcept;
+	void DoBackgroundWrite() noexcept;
+#endif
+
+#if SUPPORT_FAST_SEEK
+	bool WantClusterMap(FilePosition pos) const noexcept;
+	void CreateClusterMap() noexcept;
+	void ReleaseClusterMap() noexcept;
+#endif
+
 	volatile unsigned int openCount;
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
@@ -104,6 +145,34 @@ private:
 	static uint32_t longestWriteTime;
 #endif
 
+#if SUPPORT_BACKGROUND_WRITES
+	static FileStore *volatile _ecv_null queuedWrite;		// file whose spare buffer is waiting to be written by the file writer task
+	static FileStore *volatile _ecv_null activeWrite;		// file whose spare buffer is being written
+	static uint32_t backgroundBytesWritten, backgroundWriteTicks, numBackgroundWrites, numBackgroundWaits;
+
+	FileWriteBuffer *_ecv_null spareWriteBuffer;		// if this is not null then full write buffers are written in the background
+	volatile bool backgroundWriteFailed;
+	uint8_t backgroundVolume;
+#endif
+
+#if SUPPORT_FAST_SEEK
+	static constexpr FilePosition MinClustersForFastSeek = 4;		// don't bother with a cluster map for files smaller than this many clusters
+# if SAME70
+	static constexpr size_t NumClusterMaps = 4;
+	static constexpr size_t ClusterMapSize = 64;					// enough for 31 fragments
+# else
+	static constexpr size_t NumClusterMaps = 2;
+	static constexpr size_t ClusterMapSize = 32;					// enough for 15 fragments
+# endif
+	static DWORD clusterMaps[NumClusterMaps][ClusterMapSize];
+	static bool clusterMapInUse[NumClusterMaps];
+	static uint32_t numMapsCreated, numMapsTooFragmented, numMapsUnavailable, numFastSeeks;
+	static uint32_t longestMapCreateTicks;
+
+	DWORD *_ecv_array _ecv_null clusterMap;		// if this is not null then the file is using it for fast seeking
+	bool clusterMapFailed;						// true if we already failed to create a cluster map for this file
+#endif
+
 #if HAS_SBC_INTERFACE
 	FileHandle handle;
 	FilePosition length;
@@ -113,7 +182,11 @@ private:
 	FileIndex fileIndex;
 #endif
 
-#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+#if SUPPORT_MACRO_CACHE
+	MacroCacheEntry *_ecv_null cachedMacro;		// if this is not null then we are reading the file from the macro cache
+#endif
+
+#if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE || SUPPORT_MACRO_CACHE
 	FilePosition offset;
 #endif
 
@@ -0,0 +1,223 @@
+/*
+ * MacroCache.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include "MacroCache.h"
+
+#if SUPPORT_MACRO_CACHE
+
+#include "MassStorage.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+
+MacroCacheEntry MacroCache::entries[NumEntries];
+char MacroCache::pool[PoolSize];
+size_t MacroCache::bytesCached = 0;
+uint32_t MacroCache::useCounter = 0;
+volatile uint32_t MacroCache::numFilesWritten = 0;
+uint32_t MacroCache::numHits = 0;
+uint32_t MacroCache::numMisses = 0;
+uint32_t MacroCache::numNoSpace = 0;
+
+/*static*/ unsigned int MacroCache::GetVolume(const char *_ecv_array filePath) noexcept
+{
+	return (isdigit(filePath[0]) && filePath[1] == ':') ? filePath[0] - '0' : 0;
+}
+
+// Return true if the file may have changed since we read it into the entry
+/*static*/ bool MacroCache::IsStale(const MacroCacheEntry& entry) noexcept
+{
+	return entry.seq != MassStorage::GetVolumeSeq(entry.volume) || entry.filesWritten != numFilesWritten;
+}
+
+// Discard the contents of an entry. It must not be in use.
+/*static*/ void MacroCache::Free(MacroCacheEntry& entry) noexcept
+{
+	entry.data = nullptr;
+	bytesCached -= entry.length;
+	entry.length = 0;
+	entry.path.Clear();
+}
+
+// Look for an up-to-date copy of the file in the cache. If we find one, increment its use count and return it.
+// The caller must have locked the file system mutex.
+/*static*/ MacroCacheEntry *_ecv_null MacroCache::Acquire(const char *_ecv_array filePath) noexcept
+{
+	const unsigned int volume = GetVolume(filePath);
+	if (volume < MassStorage::GetNumVolumes())
+	{
+		for (MacroCacheEntry& e : entries)
+		{
+			if (!e.IsFree() && e.volume == volume && StringEqualsIgnoreCase(filePath, e.path.c_str()))
+			{
+				if (!IsStale(e))
+				{
+					++e.useCount;
+					e.lastUsed = ++useCounter;
+					++numHits;
+					return &e;
+				}
+				if (e.useCount == 0)
+				{
+					Free(e);					// the file may have changed
+				}
+				// Keep looking, because a file that is still reading an out-of-date entry may have caused a newer copy to be loaded
+			}
+		}
+	}
+	++numMisses;
+	return nullptr;
+}
+
+// Find a gap in the pool that is large enough for the specified number of bytes, or return nullptr if there is none.
+// A gap can only start at the start of the pool or at the end of the data of an entry.
+/*static*/ char *_ecv_array _ecv_null MacroCache::FindSpace(size_t length) noexcept
+{
+	for (size_t i = 0; i <= NumEntries; ++i)
+	{
+		size_t start;
+		if (i == NumEntries)
+		{
+			start = 0;
+		}
+		else if (entries[i].IsFree() || entries[i].length == 0)
+		{
+			continue;
+		}
+		else
+		{
+			start = (entries[i].data - pool) + entries[i].length;
+		}
+
+		if (start + length <= PoolSize)
+		{
+			bool overlaps = false;
+			for (const MacroCacheEntry& e : entries)
+			{
+				if (!e.IsFree() && e.length != 0)
+				{
+					const size_t eStart = e.data - pool;
+					if (eStart < start + length && start < eStart + e.length)
+					{
+						overlaps = true;
+						break;
+					}
+				}
+			}
+			if (!overlaps)
+			{
+				return pool + start;
+			}
+		}
+	}
+	return nullptr;
+}
+
+// Read the whole of a file that has just been opened into the cache, evicting the least recently used entries to make room if necessary.
+// If successful, return the new entry with its use count set to 1. Otherwise return nullptr, and the file position is undefined.
+// The caller must have locked the file system mutex.
+/*static*/ MacroCacheEntry *_ecv_null MacroCache::Load(const char *_ecv_array filePath, FIL& file) noexcept
+{
+	const unsigned int volume = GetVolume(filePath);
+	const FilePosition length = f_size(&file);
+	if (volume >= MassStorage::GetNumVolumes() || length > MaxCachedFileSize || strlen(filePath) >= MaxFilenameLength)
+	{
+		return nullptr;
+	}
+
+	const uint16_t currentSeq = MassStorage::GetVolumeSeq(volume);
+	const uint32_t currentFilesWritten = numFilesWritten;
+	MacroCacheEntry *_ecv_null slot;
+	char *_ecv_array _ecv_null space = nullptr;
+	do
+	{
+		// Find a free entry, freeing any out-of-date entries that are no longer in use, and find the least recently used entry
+		slot = nullptr;
+		MacroCacheEntry *_ecv_null lruEntry = nullptr;
+		for (MacroCacheEntry& e : entries)
+		{
+			if (!e.IsFree() && e.useCount == 0 && IsStale(e))
+			{
+				Free(e);
+			}
+
+			if (e.IsFree())
+			{
+				if (slot == nullptr)
+				{
+					slot = &e;
+				}
+			}
+			else if (e.useCount == 0 && (lruEntry == nullptr || (int32_t)(e.lastUsed - lruEntry->lastUsed) < 0))
+			{
+				lruEntry = &e;
+			}
+		}
+
+		if (slot != nullptr && length != 0)
+		{
+			space = FindSpace(length);
+		}
+
+		if (slot == nullptr || (length != 0 && space == nullptr))
+		{
+			if (lruEntry == nullptr)
+			{
+				++numNoSpace;					// all the entries that we could evict are in use
+				return nullptr;
+			}
+			Free(*lruEntry);
+			slot = nullptr;
+		}
+	} while (slot == nullptr);
+
+	if (length != 0)
+	{
+		UINT bytesRead;
+		if (f_read(&file, space, length, &bytesRead) != FR_OK || bytesRead != length)
+		{
+			return nullptr;
+		}
+		slot->data = space;
+	}
+
+	slot->length = length;
+	bytesCached += length;
+	slot->volume = volume;
+	slot->seq = currentSeq;
+	slot->filesWritten = currentFilesWritten;
+	slot->useCount = 1;
+	slot->lastUsed = ++useCounter;
+	slot->path.copy(filePath);
+	return slot;
+}
+
+// Release an entry when a file reading it is closed. This doesn't need the file system mutex to be locked.
+/*static*/ void MacroCache::Release(MacroCacheEntry *entry) noexcept
+{
+	const irqflags_t flags = IrqSave();
+	--entry->useCount;
+	IrqRestore(flags);
+}
+
+/*static*/ void MacroCache::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int numCached = 0;
+	for (const MacroCacheEntry& e : entries)
+	{
+		if (!e.IsFree())
+		{
+			++numCached;
+		}
+	}
+	const uint32_t numLookups = numHits + numMisses;
+	reprap.GetPlatform().MessageF(mtype, "Macro cache: %u files using %u of %u bytes, %" PRIu32 " hits, %" PRIu32 " misses, hit rate %.1f%%, %" PRIu32 " no space\n",
+									numCached, bytesCached, PoolSize, numHits, numMisses, (double)((numLookups == 0) ? 0.0 : (float)numHits * 100.0/(float)numLookups), numNoSpace);
+	numHits = numMisses = numNoSpace = 0;
+}
+
+#endif
+
+// End
@@ -0,0 +1,78 @@
+/*
+ * MacroCache.h
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SRC_STORAGE_MACROCACHE_H_
+#define SRC_STORAGE_MACROCACHE_H_
+
+#include <RepRapFirmware.h>
+#include "FileStore.h"
+
+#if SUPPORT_MACRO_CACHE
+
+// The contents of a macro file held in RAM
+class MacroCacheEntry
+{
+public:
+	MacroCacheEntry() noexcept : data(nullptr), length(0), lastUsed(0), filesWritten(0), useCount(0), seq(0), volume(0) { }
+
+	const char *_ecv_array _ecv_null GetData() const noexcept { return data; }
+	FilePosition GetLength() const noexcept { return length; }
+
+private:
+	friend class MacroCache;
+
+	bool IsFree() const noexcept { return path.IsEmpty(); }
+
+	char *_ecv_array _ecv_null data;
+	FilePosition length;
+	uint32_t lastUsed;
+	uint32_t filesWritten;							// the value of MacroCache::numFilesWritten when we read the file
+	volatile unsigned int useCount;					// the number of FileStore objects reading from this entry
+	uint16_t seq;									// the volume sequence number when we read the file
+	uint8_t volume;
+	String<MaxFilenameLength> path;
+};
+
+// Cache of recently used macro files, so that running tool change files and daemon.g doesn't need to read the SD card every time.
+// An entry is discarded when the sequence number of its volume changes, which happens when any file on it is created, deleted or renamed, or the volume is mounted.
+// It is also discarded when any file that was opened for writing or appending is closed, because the file may have been written after we read it.
+// The file contents are held in a statically allocated pool. If a file doesn't fit in the pool, it is read from the card instead.
+// The functions that acquire entries must be called with the file system mutex locked.
+class MacroCache
+{
+public:
+	static MacroCacheEntry *_ecv_null Acquire(const char *_ecv_array filePath) noexcept;
+	static MacroCacheEntry *_ecv_null Load(const char *_ecv_array filePath, FIL& file) noexcept;
+	static void Release(MacroCacheEntry *entry) noexcept;
+	static void FileClosedAfterWriting() noexcept { ++numFilesWritten; }
+	static void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	static void Free(MacroCacheEntry& entry) noexcept;
+	static bool IsStale(const MacroCacheEntry& entry) noexcept;
+	static char *_ecv_array _ecv_null FindSpace(size_t length) noexcept;
+	static unsigned int GetVolume(const char *_ecv_array filePath) noexcept;
+
+#if SAME70
+	static constexpr size_t NumEntries = 12;
+	static constexpr size_t PoolSize = 24 * 1024;
+#else
+	static constexpr size_t NumEntries = 8;
+	static constexpr size_t PoolSize = 6 * 1024;
+#endif
+	static constexpr size_t MaxCachedFileSize = PoolSize/2;
+
+	static MacroCacheEntry entries[NumEntries];
+	static char pool[PoolSize];
+	static size_t bytesCached;
+	static uint32_t useCounter;
+	static volatile uint32_t numFilesWritten;
+	static uint32_t numHits, numMisses, numNoSpace;
+};
+
+#endif
+
+#endif /* SRC_STORAGE_MACROCACHE_H_ */
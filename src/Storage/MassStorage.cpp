@@ -2,6 +2,8 @@
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
 #include <ObjectModel/ObjectModel.h>
+#include "MacroCache.h"
+#include "DirectoryCache.h"
 
 #if HAS_MASS_STORAGE
 # include <Libraries/Fatfs/diskio.h>
@@ -335,6 +337,10 @@ void MassStorage::Init() noexcept
 	dirMutex.Create("DirSearch");
 #endif
 
+#if SUPPORT_DIRECTORY_CACHE
+	DirectoryCache::Init();
+#endif
+
 # if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	freeWriteBuffers = nullptr;
 	for (size_t i = 0; i < NumFileWriteBuffers; ++i)
@@ -364,6 +370,12 @@ void MassStorage::Init() noexcept
 	}
 
 	sd_mmc_init(SdWriteProtectPins, SdSpiCSPins);		// initialize SD MMC stack
+#  if SUPPORT_SD_READ_CACHE
+	DiskioInit();
+#  endif
+#  if SUPPORT_BACKGROUND_WRITES
+	FileStore::BackgroundWriterInit();
+#  endif
 
 	// We no longer mount the SD card here because it may take a long time if it fails
 # endif
@@ -443,6 +455,10 @@ void MassStorage::Spin() noexcept
 			}
 		}
 	}
+
+# if SUPPORT_FILE_INFO_CACHE
+	infoParser.Spin();
+# endif
 }
 
 FileStore* MassStorage::OpenFile(const char* filePath, OpenMode mode, uint32_t preAllocSize) noexcept
@@ -539,6 +555,22 @@ FileWriteBuffer *MassStorage::AllocateWriteBuffer() noexcept
 	return buffer;
 }
 
+// Allocate a write buffer only if that leaves at least one free, so that a file opened for writing later can still get one
+FileWriteBuffer *MassStorage::AllocateSpareWriteBuffer() noexcept
+{
+	MutexLocker lock(fsMutex);
+
+	FileWriteBuffer * const buffer = freeWriteBuffers;
+	if (buffer != nullptr && buffer->Next() != nullptr)
+	{
+		freeWriteBuffers = buffer->Next();
+		buffer->SetNext(nullptr);
+		buffer->DataTaken();				// make sure that the write pointer is clear
+		return buffer;
+	}
+	return nullptr;
+}
+
 void MassStorage::ReleaseWriteBuffer(FileWriteBuffer *buffer) noexcept
 {
 	MutexLocker lock(fsMutex);
@@ -582,6 +614,10 @@ void MassStorage::InvalidateAllFiles() noexcept
 // Delete a file or directory
 static bool InternalDelete(const char* filePath, bool messageIfFailed) noexcept
 {
+#  if SUPPORT_FILE_INFO_CACHE
+	infoParser.StopBackgroundScan(filePath);				// don't fail because the file is being parsed in the background
+#  endif
+
 	FRESULT unlinkReturn;
 	bool isOpen = false;
 
@@ -864,6 +900,9 @@ bool MassStorage::Rename(const char *oldFilename, const char *newFilename, bool
 	{
 		return false;
 	}
+#if SUPPORT_FILE_INFO_CACHE
+	infoParser.StopBackgroundScan(oldFilename);
+#endif
 	if (deleteExisting && (FileExists(newFilename) || DirectoryExists(newFilename)))
 	{
 		if (!InternalDelete(newFilename, messageIfFailed))
@@ -923,6 +962,19 @@ time_t MassStorage::GetLastModifiedTime(const char *filePath) noexcept
 	return 0;
 }
 
+// Get the size and last modified time of a file without opening it, returning true if successful
+bool MassStorage::GetFileSizeAndTime(const char *filePath, FilePosition& size, time_t& lastModified) noexcept
+{
+	FILINFO fil;
+	if (f_stat(filePath, &fil) == FR_OK && (fil.fattrib & AM_DIR) == 0)
+	{
+		size = fil.fsize;
+		lastModified = ConvertTimeStamp(fil.fdate, fil.ftime);
+		return true;
+	}
+	return false;
+}
+
 bool MassStorage::SetLastModifiedTime(const char *filePath, time_t time) noexcept
 {
 	tm timeInfo;
@@ -1134,6 +1186,30 @@ GCodeResult MassStorage::GetFileInfo(const char *filePath, GCodeFileInfo& info,
 	return infoParser.GetFileInfo(filePath, info, quitEarly);
 }
 
+#if SUPPORT_FILE_INFO_CACHE
+
+void MassStorage::QueueFileInfoScan(const char *filePath) noexcept
+{
+	infoParser.QueueBackgroundScan(filePath);
+}
+
+#endif
+
+// Statistics for reads made by the G-code file input, which stalls the file channel until each read completes
+static uint32_t fileInputBytesRead = 0;
+static uint32_t fileInputReadTicks = 0;
+static uint32_t fileInputLongestReadTicks = 0;
+
+void MassStorage::RecordFileInputRead(size_t bytesRead, uint32_t readTicks) noexcept
+{
+	fileInputBytesRead += bytesRead;
+	fileInputReadTicks += readTicks;
+	if (readTicks > fileInputLongestReadTicks)
+	{
+		fileInputLongestReadTicks = readTicks;
+	}
+}
+
 void MassStorage::Diagnostics(MessageType mtype) noexcept
 {
 	Platform& platform = reprap.GetPlatform();
@@ -1141,6 +1217,33 @@ void MassStorage::Diagnostics(MessageType mtype) noexcept
 	// Show the number of free entries in the file table
 	platform.MessageF(mtype, "=== Storage ===\nFree file entries: %u\n", MassStorage::GetNumFreeFiles());
 
+	// Show the G-code file input throughput and the time the file channel spent waiting for reads
+	platform.MessageF(mtype, "File input read %" PRIu32 " bytes at %.2fMbytes/sec, stall time %.1fms, longest %.1fms\n",
+								fileInputBytesRead,
+								(double)((float)fileInputBytesRead * (float)StepClockRate * 0.000001/(float)max<uint32_t>(fileInputReadTicks, 1)),
+								(double)((float)fileInputReadTicks * StepClocksToMillis), (double)((float)fileInputLongestReadTicks * StepClocksToMillis));
+	fileInputBytesRead = fileInputReadTicks = fileInputLongestReadTicks = 0;
+
+# if SUPPORT_MACRO_CACHE
+	MacroCache::Diagnostics(mtype);
+# endif
+
+# if SUPPORT_FILE_INFO_CACHE
+	infoParser.Diagnostics(mtype);
+# endif
+
+# if SUPPORT_DIRECTORY_CACHE
+	DirectoryCache::Diagnostics(mtype);
+# endif
+
+# if SUPPORT_FAST_SEEK
+	FileStore::FastSeekDiagnostics(mtype);
+# endif
+
+# if SUPPORT_BACKGROUND_WRITES
+	FileStore::BackgroundWriterDiagnostics(mtype);
+# endif
+
 # if HAS_MASS_STORAGE
 #  if HAS_HIGH_SPEED_SD
 	// Show the HSMCI CD pin and speed
@@ -1153,6 +1256,9 @@ void MassStorage::Diagnostics(MessageType mtype) noexcept
 	// Show the longest SD card write time
 	platform.MessageF(mtype, "SD card longest read time %.1fms, write time %.1fms, max retries %u\n",
 								(double)DiskioGetAndClearLongestReadTime(), (double)DiskioGetAndClearLongestWriteTime(), DiskioGetAndClearMaxRetryCount());
+#  if SUPPORT_SD_READ_CACHE
+	DiskioCacheDiagnostics(mtype);
+#  endif
 # endif
 }
 
@@ -1205,6 +1311,9 @@ void MassStorage::RecordSimulationTime(const char *printingFilePath, uint32_t si
 		{
 			ok = SetLastModifiedTime(printingFilePath, lastModtime);
 		}
+# if SUPPORT_FILE_INFO_CACHE
+		infoParser.ForgetFile(printingFilePath);						// the size of the file may not have changed, but the simulated time has
+# endif
 	}
 
 	if (!ok)
@@ -57,6 +57,7 @@ namespace MassStorage
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	FileWriteBuffer *AllocateWriteBuffer() noexcept;
+	FileWriteBuffer *AllocateSpareWriteBuffer() noexcept;
 	size_t GetFileWriteBufferLength() noexcept;
 	void ReleaseWriteBuffer(FileWriteBuffer *buffer) noexcept;
 	bool Delete(const char* filePath, bool messageIfFailed) noexcept;
@@ -79,6 +80,7 @@ namespace MassStorage
 	GCodeResult Mount(size_t card, const StringRef& reply, bool reportSuccess) noexcept;
 	GCodeResult Unmount(size_t card, const StringRef& reply) noexcept;
 	void Diagnostics(MessageType mtype) noexcept;
+	void RecordFileInputRead(size_t bytesRead, uint32_t readTicks) noexcept;				// Record the time taken by a G-code file input read for diagnostics
 #endif
 
 #if HAS_MASS_STORAGE
@@ -86,6 +88,7 @@ namespace MassStorage
 	bool MakeDirectory(const char *_ecv_array directory, bool messageIfFailed) noexcept;
 	bool Rename(const char *_ecv_array oldFilePath, const char *_ecv_array newFilePath, bool deleteExisting, bool messageIfFailed) noexcept;
 	time_t GetLastModifiedTime(const char *_ecv_array filePath) noexcept;
+	bool GetFileSizeAndTime(const char *_ecv_array filePath, FilePosition& size, time_t& lastModified) noexcept;
 	bool SetLastModifiedTime(const char *_ecv_array file, time_t t) noexcept;
 	bool CheckDriveMounted(const char* path) noexcept;
 	bool IsCardDetected(size_t card) noexcept;
@@ -94,6 +97,9 @@ namespace MassStorage
 	Mutex& GetVolumeMutex(size_t vol) noexcept;
 	void RecordSimulationTime(const char *_ecv_array printingFilePath, uint32_t simSeconds) noexcept;	// Append the simulated printing time to the end of the file
 	uint16_t GetVolumeSeq(unsigned int volume) noexcept;
+# if SUPPORT_FILE_INFO_CACHE
+	void QueueFileInfoScan(const char *_ecv_array filePath) noexcept;					// Parse a G-code file in the background so that its information is ready when a client asks for it
+# endif
 
 	enum class InfoResult : uint8_t
 	{